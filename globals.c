@@ -14,24 +14,9 @@
  * @bug No known bugs.
  */
 
-#include "globals.h"
-
-/**
- * @brief Local global variable used to detect errors in example or testing
- * sets.
- */
-static int error_in_set;
+#include <pthread.h>
 
-/**
- * @brief Local variable used to detect the missing value attributes count.
- */
-static int missing_count;
-
-/**
- * @brief Local global variable used to detect the missing values while
- * printing.
- */
-static int missing_indexes[MISS_COUNT];
+#include "globals.h"
 
 /**
  * @brief Reads a set to use when learning (learning = 1) or classifying
@@ -71,17 +56,18 @@ static struct attribute *read_attribute(FILE *file);
  * @return The read example.
  */
 static struct example *read_example(FILE *file, int learning,
-		const struct description *descr,
-		struct example_set *set);
+		const struct description *descr, struct example_set *set);
 
 /**
  * @brief Writes an example to a file.
  *
  * @param ex Example to be written.
+ * @param set The example set from which this example is part of.
  * @param descr Description to use while writing.
  * @param file File to write to.
  */
 static void write_example(const struct example *ex,
+		const struct example_set *set,
 		const struct description *descr,
 		FILE *file);
 
@@ -98,19 +84,12 @@ static void write_attribute(const struct attribute *attr, FILE *file);
  * position.
  *
  * @param ex Example to test
+ * @param set The example set from which this example is part of.
  * @param index Where to look
  * @return 1 if missing, 0 otherwise.
  */
-static int missing_value(const struct example *ex, int index);
-
-/**
- * @brief Records a new missing value from the learning set.
- *
- * @param index Index of attribute
- * @param set Example set in which to record the missing value
- * @return Change in flag to record missing value or 0 on error
- */
-static int record_missing(int index, struct example_set *set);
+static int missing_value(const struct example *ex,
+		const struct example_set *set, int index);
 
 /**
  * @brief Gets the mapping between the read attribute value and the indexes
@@ -118,10 +97,51 @@ static int record_missing(int index, struct example_set *set);
  *
  * @param string The read string
  * @param attr The corresponding attribute
- * @return The index from the mapping
+ * @param index Output: the index from the mapping
+ * @return 0 on success, -1 if the value is not valid for the attribute
  */
 static int get_index_from_descr(const char *string,
-		const struct attribute *attr);
+		const struct attribute *attr, int *index);
+
+/**
+ * @brief Nodes of a classifier, indexed by tag.
+ *
+ * Used to resolve the references to shared nodes while reading a
+ * classifier and to remember the shared nodes already written.
+ */
+struct tag_table {
+	/** Count of entries */
+	int count;
+	/** Node with each tag (NULL if not known) */
+	const struct classifier **nodes;
+};
+
+/**
+ * @brief Reads one node of a classifier (and its subtree).
+ *
+ * @param file File to read from
+ * @param table Nodes already read (with their subtrees)
+ * @return The node or NULL on error
+ */
+static struct classifier *read_node(FILE *file, struct tag_table *table);
+
+/**
+ * @brief Writes one node of a classifier (and its subtree).
+ *
+ * @param cls The node
+ * @param table Shared nodes already written
+ * @param file File to write to.
+ */
+static void write_node(const struct classifier *cls,
+		struct tag_table *table, FILE *file);
+
+/**
+ * @brief Records a node in a tag table.
+ *
+ * @param table The table
+ * @param cls The node
+ */
+static void table_add(struct tag_table *table, const struct classifier *cls);
 
 /**
  * @brief Frees one attribute from a description.
@@ -133,13 +153,26 @@ static int get_index_from_descr(const char *string,
 static void free_attribute(struct attribute *ptr);
 
 /**
- * @brief Frees one example from an example set.
- *
- * Does NOT free the pointer itselt.
+ * @brief Tasks shared by the threads of run_tasks.
+ */
+struct task_queue {
+	/** Function running one task */
+	void (*task)(void *arg, int index);
+	/** Argument of the function */
+	void *arg;
+	/** Count of tasks */
+	int count;
+	/** Index of next task to run */
+	int next;
+};
+
+/**
+ * @brief Thread function running tasks until none is left.
  *
- * @param ptr Pointer to the example.
+ * @param arg The struct task_queue
+ * @return NULL
  */
-static void free_example(struct example *ptr);
+static void *run_queue(void *arg);
 
 void *free_and_set_NULL(void *ptr)
 {
@@ -222,7 +255,6 @@ fail:
 struct example_set *read_learning_file(FILE *file,
 		const struct description *descr)
 {
-	missing_count = 0;
 	return read_set(file, 1, descr);
 }
 
@@ -232,6 +264,17 @@ struct example_set *read_testing_file(FILE *file,
 	return read_set(file, 0, descr);
 }
 
+int read_testing_header(FILE *file)
+{
+	int N;
+
+	CHECK(fscanf(file, "%d", &N) == 1, fail);
+	CHECK(N >= 0, fail);
+	return N;
+fail:
+	return -1;
+}
+
 struct example_set *read_set(FILE *file, int learning,
 		const struct description *descr)
 {
@@ -256,43 +299,42 @@ fail:
 }
 
 int get_index_from_descr(const char *string,
-		const struct attribute *attr)
+		const struct attribute *attr, int *index)
 {
-	int index, l;
+	int l;
 
 	if (attr->type == NUMERIC) {
-		CHECK(sscanf(string, "%d", &index) == 1, fail);
-		return index;
+		CHECK(sscanf(string, "%d", index) == 1, fail);
+		return 0;
 	}
 
 	l = strlen(string);
-	for (index = 0; index < attr->C; index++)
-		if (strncmp(string, (char *)attr->ptr[index], l) == 0)
-			return index;
+	for (*index = 0; *index < attr->C; (*index)++)
+		if (strncmp(string, (char *)attr->ptr[*index], l) == 0)
+			return 0;
 fail:
-	error_in_set = 1;
-	return 0;
+	*index = 0;
+	return -1;
 }
 
 int record_missing(int index, struct example_set *set)
 {
 	int i;
 
-	for (i = 0; i < missing_count; i++)
+	for (i = 0; i < set->missing_count; i++)
 		if (set->missing[i] == index)
 			return 1 << i;
 
-	CHECK(missing_count < MISS_COUNT, fail);
-	set->missing[missing_count++] = index;
-	return 1 << (missing_count - 1);
+	CHECK(set->missing_count < MISS_COUNT, fail);
+	set->missing[set->missing_count++] = index;
+	return 1 << (set->missing_count - 1);
 
 fail:
 	return 0;
 }
 
 struct example *read_example(FILE *file, int learning,
-		const struct description *descr,
-		struct example_set *set)
+		const struct description *descr, struct example_set *set)
 {
 	struct example *ex;
 	char *tmp = NULL;
@@ -307,12 +349,9 @@ struct example *read_example(FILE *file, int learning,
 			l = record_missing(i, set);
 			CHECK(l != 0, fail);
 			ex->miss |= l;
-		} else {
-			error_in_set = 0;
-			ex->attr_ids[i] = get_index_from_descr(tmp,
-					descr->attribs[i]);
-			CHECK(error_in_set == 0, fail);
-		}
+		} else
+			CHECK(get_index_from_descr(tmp, descr->attribs[i],
+					&ex->attr_ids[i]) == 0, fail);
 		tmp = free_and_set_NULL(tmp);
 	}
 
@@ -336,28 +375,126 @@ fail:
 	return free_and_set_NULL(tmp);
 }
 
+int parse_testing_line(char *line, const struct description *descr,
+		int *attr_ids)
+{
+	return parse_testing_example(line, descr, NULL, attr_ids, NULL);
+}
+
+int parse_testing_example(char *line, const struct description *descr,
+		const int *used, int *attr_ids, int *missing)
+{
+	char *tok, *save;
+	int i, m;
+
+	for (i = 0, m = 0; i < descr->M; i++) {
+		tok = strtok_r(i ? NULL : line, " \t\r\n", &save);
+		CHECK(tok != NULL, fail);
+		attr_ids[i] = 0;
+		SKIPIF(used && !used[i]);
+		if (strncmp(tok, "?", 1) == 0) {
+			SKIPIF(missing == NULL);
+			CHECK(m < MISS_COUNT, fail);
+			missing[m++] = i;
+			continue;
+		}
+		CHECK(get_index_from_descr(tok, descr->attribs[i],
+				&attr_ids[i]) == 0, fail);
+	}
+	for (; missing && m < MISS_COUNT; m++)
+		missing[m] = -1;
+	return 0;
+fail:
+	return -1;
+}
+
 struct classifier *read_classifier(FILE *file)
+{
+	struct tag_table table = {0, NULL};
+	struct classifier *cls;
+
+	cls = read_node(file, &table);
+	free(table.nodes);
+	return cls;
+}
+
+int read_forest_size(FILE *file)
+{
+	int count;
+
+	/* a classifier starts with a tag, not with the forest keyword */
+	if (fscanf(file, " forest %d", &count) != 1)
+		return 1;
+	return count;
+}
+
+struct classifier *read_node(FILE *file, struct tag_table *table)
 {
 	struct classifier *cls, *tmp;
 	int i;
 
 	cls = calloc(1, sizeof(*cls));
 	CHECK(fscanf(file, "%d%d%d", &cls->tag, &cls->id, &cls->C) == 3, fail);
+	if (cls->C == CLS_REF) {
+		CHECK(cls->tag >= 0 && cls->tag < table->count, ref);
+		tmp = (struct classifier *)table->nodes[cls->tag];
+		CHECK(tmp != NULL, ref);
+		tmp->shared++;
+		free(cls);
+		return tmp;
+	}
+	CHECK(cls->C >= 0, fail);
 	cls->values = calloc(cls->C, sizeof(cls->values[0]));
 	cls->cls = calloc(cls->C, sizeof(cls->cls[0]));
 	for (i = 0; i < cls->C; i++)
 		CHECK(fscanf(file, "%d", &cls->values[i]) == 1, fail);
 	for (i = 0; i < cls->C; i++) {
-		tmp = read_classifier(file);
+		tmp = read_node(file, table);
 		CHECK(tmp != NULL, fail);
 		cls->cls[i] = tmp;
 	}
+	/* only complete nodes can be referenced, thus no cycles */
+	table_add(table, cls);
 	return cls;
+ref:
+	cls->C = 0;
 fail:
 	free_classifier(cls);
 	return NULL;
 }
 
+void table_add(struct tag_table *table, const struct classifier *cls)
+{
+	int count;
+
+	if (cls->tag < 0)
+		return;
+	if (cls->tag >= table->count) {
+		count = 2 * cls->tag + 1;
+		table->nodes = realloc(table->nodes,
+				count * sizeof(table->nodes[0]));
+		memset(table->nodes + table->count, 0,
+				(count - table->count) *
+				sizeof(table->nodes[0]));
+		table->count = count;
+	}
+	table->nodes[cls->tag] = cls;
+}
+
+int classifier_attributes(const struct classifier *cls, int *used)
+{
+	int i, count;
+
+	if (cls == NULL || cls->C == 0)
+		return 0;
+
+	count = !used[cls->id];
+	used[cls->id] = 1;
+	for (i = 0; i < cls->C; i++)
+		count += classifier_attributes(cls->cls[i], used);
+	return count;
+}
+
 void write_attribute(const struct attribute *attr, FILE *file)
 {
 	int i;
@@ -393,32 +530,31 @@ void write_set(const struct example_set *set,
 {
 	int i;
 
-	for (i = 0; i < MISS_COUNT; i++)
-		missing_indexes[i] = set->missing[i];
-
 	fprintf(file, "%d\n", set->N);
 	for (i = 0; i < set->N; i++)
-		write_example(set->examples[i], descr, file);
+		write_example(set->examples[i], set, descr, file);
 }
 
-int missing_value(const struct example *ex, int index)
+int missing_value(const struct example *ex,
+		const struct example_set *set, int index)
 {
 	int i;
 
-	for (i = 0; i < MISS_COUNT; i++)
-		if (index == missing_indexes[i] && MISS_INDEX(ex->miss, i))
+	for (i = 0; i < set->missing_count; i++)
+		if (index == set->missing[i] && MISS_INDEX(ex->miss, i))
 			return 1;
 	return 0;
 }
 
 void write_example(const struct example *ex,
+	const struct example_set *set,
 	const struct description *descr,
 	FILE *file)
 {
 	int i;
 
 	for (i = 0; i < descr->M; i++)
-		if (missing_value(ex, i))
+		if (missing_value(ex, set, i))
 			fprintf(file, "? ");
 		else if (descr->attribs[i]->type == NUMERIC)
 			fprintf(file, "%d ", ex->attr_ids[i]);
@@ -430,19 +566,36 @@ void write_example(const struct example *ex,
 }
 
 void write_classifier(const struct classifier *cls, FILE *file)
+{
+	struct tag_table table = {0, NULL};
+
+	write_node(cls, &table, file);
+	free(table.nodes);
+}
+
+void write_node(const struct classifier *cls, struct tag_table *table,
+		FILE *file)
 {
 	int i;
 
 	if (cls == NULL)
 		return;
 
+	if (cls->shared && cls->tag >= 0) {
+		if (cls->tag < table->count && table->nodes[cls->tag] == cls) {
+			fprintf(file, "%d %d %d\n", cls->tag, cls->id, CLS_REF);
+			return;
+		}
+		table_add(table, cls);
+	}
+
 	fprintf(file, "%d %d %d", cls->tag, cls->id, cls->C);
 	for (i = 0; i < cls->C; i++)
 		fprintf(file, " %d", cls->values[i]);
 	fprintf(file, "\n");
 
 	for (i = 0; i < cls->C; i++)
-		write_classifier(cls->cls[i], file);
+		write_node(cls->cls[i], table, file);
 }
 
 void write_id3_temp_file(const struct description *descr,
@@ -453,6 +606,18 @@ void write_id3_temp_file(const struct description *descr,
 	write_classifier(cls, file);
 }
 
+void write_forest_file(const struct description *descr,
+		struct classifier *const *trees, int count,
+		FILE *file)
+{
+	int i;
+
+	write_description(descr, file);
+	fprintf(file, "forest %d\n", count);
+	for (i = 0; i < count; i++)
+		write_classifier(trees[i], file);
+}
+
 void clear_filter_info(const struct example_set *lset)
 {
 	int i;
@@ -482,6 +647,56 @@ ok:
 	free_and_set_NULL(ptr->ptr);
 }
 
+struct description *copy_description(const struct description *descr)
+{
+	const struct attribute *from;
+	struct description *desc;
+	struct attribute *attr;
+	int i, j;
+
+	desc = calloc(1, sizeof(*desc));
+	desc->K = descr->K;
+	desc->classes = calloc(desc->K, sizeof(desc->classes[0]));
+	for (i = 0; i < desc->K; i++)
+		desc->classes[i] = strdup(descr->classes[i]);
+
+	desc->M = descr->M;
+	desc->attribs = calloc(desc->M, sizeof(desc->attribs[0]));
+	for (i = 0; i < desc->M; i++) {
+		from = descr->attribs[i];
+		attr = calloc(1, sizeof(*attr));
+		desc->attribs[i] = attr;
+		attr->name = strdup(from->name);
+		attr->type = from->type;
+		attr->C = from->C;
+		SKIPIF(from->ptr == NULL);
+		attr->ptr = calloc(attr->C, sizeof(attr->ptr[0]));
+		for (j = 0; j < attr->C; j++)
+			attr->ptr[j] = attr->type == NUMERIC ? from->ptr[j] :
+				(long long)strdup((char *)from->ptr[j]);
+	}
+	return desc;
+}
+
+struct example_set *copy_example_set(const struct example_set *set, int M)
+{
+	struct example_set *copy;
+	int i;
+
+	copy = calloc(1, sizeof(*copy));
+	*copy = *set;
+	copy->examples = calloc(set->N, sizeof(copy->examples[0]));
+	for (i = 0; i < set->N; i++) {
+		copy->examples[i] = calloc(1, sizeof(*copy->examples[i]));
+		*copy->examples[i] = *set->examples[i];
+		copy->examples[i]->attr_ids = calloc(M,
+				sizeof(copy->examples[i]->attr_ids[0]));
+		memcpy(copy->examples[i]->attr_ids, set->examples[i]->attr_ids,
+				M * sizeof(copy->examples[i]->attr_ids[0]));
+	}
+	return copy;
+}
+
 void free_description(struct description *ptr)
 {
 	int i;
@@ -531,6 +746,10 @@ void free_classifier(struct classifier *ptr)
 
 	if (ptr == NULL)
 		return;
+	if (ptr->shared) {
+		ptr->shared--;
+		return;
+	}
 
 	for (i = 0; i < ptr->C; i++)
 		free_classifier(ptr->cls[i]);
@@ -545,6 +764,48 @@ int set_error(int err)
 	return err;
 }
 
+void run_tasks(int jobs, int count, void (*task)(void *arg, int index),
+		void *arg)
+{
+	struct task_queue queue;
+	pthread_t *threads;
+	int i, started;
+
+	queue.task = task;
+	queue.arg = arg;
+	queue.count = count;
+	queue.next = 0;
+
+	if (jobs > count)
+		jobs = count;
+	if (jobs <= 1) {
+		run_queue(&queue);
+		return;
+	}
+
+	threads = calloc(jobs, sizeof(threads[0]));
+	for (started = 0; started < jobs; started++)
+		if (pthread_create(&threads[started], NULL, run_queue, &queue))
+			break;
+	/* without all the threads, the tasks left are run here */
+	if (started < jobs)
+		run_queue(&queue);
+	for (i = 0; i < started; i++)
+		pthread_join(threads[i], NULL);
+	free(threads);
+}
+
+void *run_queue(void *arg)
+{
+	struct task_queue *queue = arg;
+	int i;
+
+	while ((i = __atomic_fetch_add(&queue->next, 1, __ATOMIC_RELAXED)) <
+			queue->count)
+		queue->task(queue->arg, i);
+	return NULL;
+}
+
 int get_double_min(double *v, int size)
 {
 	double min;
@@ -40,16 +40,26 @@
 
 #define NUM_DIV 1 /**< @brief handle numeric attributes by binary split */
 #define NUM_FULL 2 /**< @brief full handling of numeric attributes */
+#define NUM_LOCAL 3 /**< @brief binary split chosen at each node */
 
 #define MISS_MAJ 1 /**< @brief replace missing attributes with the majority */
 #define MISS_PRB 2 /**< @brief use probabilities to guess the missing values */
 
+#define PRUNE_NONE 0 /**< @brief don't prune the learned tree */
+#define PRUNE_COL 1 /**< @brief collapse nodes giving a single class */
+#define PRUNE_PES 2 /**< @brief pessimistic error pruning */
+#define PRUNE_REP 3 /**< @brief reduced error pruning (needs a holdout set) */
+
 #define TREE_ASCII 1 /**< @brief output ID3 tree in ASCII */
 #define TREE_DOT 2 /**< @brief output ID3 tree using Dot */
 #define TREE_SCHEME 3 /**< @brief output ID3 tree as Scheme/Lisp functions */
+#define TREE_C 4 /**< @brief output ID3 tree as a C function */
 
 #define MISS_COUNT 2 /**< @brief max number of missing columns */
 
+#define CLS_REF -1 /**< @brief count of branches of a reference to a node */
+#define CLS_ANY -1 /**< @brief value of the default branch of a discrete node */
+
 /**
  * @brief Macro used to determine if a bit is set in a flag.
  *
@@ -159,7 +169,8 @@ struct example {
 /**
  * @brief Structure representing the learning set.
  *
- * The missing vector contains the indexes of missing value attributes.
+ * The missing vector contains the indexes of missing value attributes, only
+ * the first missing_count of them being used.
  */
 struct example_set {
 	/** Number of samples */
@@ -168,10 +179,22 @@ struct example_set {
 	struct example **examples;
 	/** Missing columns */
 	int missing[MISS_COUNT];
+	/** Count of missing columns */
+	int missing_count;
 };
 
 /**
  * @brief Structure representing the id3 classifier (or id3 tree).
+ *
+ * The branches of a discrete node are tested in order, the first one having
+ * the value of the example being taken. The last branch can have CLS_ANY as
+ * value, matching every value (this is how the values not seen while
+ * learning share a single leaf).
+ *
+ * Identical subtrees may be shared (see share_subtrees), making the
+ * classifier a directed acyclic graph. A shared node is written only once in
+ * a file, the next occurrences being written as references: the tag of the
+ * node, its id and CLS_REF as count of branches.
  */
 struct classifier {
 	/** Id of classifier (tag used to generate it) */
@@ -184,6 +207,8 @@ struct classifier {
 	int *values;
 	/** Branches (size is given by C) */
 	struct classifier **cls;
+	/** Count of parents besides the first one (0 if not shared) */
+	int shared;
 };
 
 /**
@@ -220,6 +245,60 @@ struct example_set *read_learning_file(FILE *file,
 struct example_set *read_testing_file(FILE *file,
 		const struct description *descr);
 
+/**
+ * @brief Reads the header of a testing set, without reading any example.
+ *
+ * Used to classify a testing set one line at a time (see
+ * parse_testing_example), without keeping the entire set in memory.
+ *
+ * @param file Testing set file
+ * @return Count of examples announced by the file or -1 on error.
+ */
+int read_testing_header(FILE *file);
+
+/**
+ * @brief Parses one example of a testing set given as a line of text.
+ *
+ * The line contains the values of the attributes separated by whitespace,
+ * as in a testing file. Missing values (?) are replaced by 0. The line is
+ * modified while parsing.
+ *
+ * @param line The line
+ * @param descr The description of the entire model.
+ * @param attr_ids Output: values of the attributes (descr->M of them)
+ * @return 0 on success, -1 on error
+ */
+int parse_testing_line(char *line, const struct description *descr,
+		int *attr_ids);
+
+/**
+ * @brief Parses one example of a testing set, as parse_testing_line, also
+ * returning the missing attributes.
+ *
+ * Only the attributes marked in used are decoded and checked, the values of
+ * the others are skipped and set to 0.
+ *
+ * @param line The line
+ * @param descr The description of the entire model.
+ * @param used Attributes to decode (NULL for all of them)
+ * @param attr_ids Output: values of the attributes (descr->M of them)
+ * @param missing Output: indexes of the missing attributes, -1 for the
+ * unused entries (MISS_COUNT of them, NULL if not needed)
+ * @return 0 on success, -1 on error (also if more than MISS_COUNT values
+ * are missing)
+ */
+int parse_testing_example(char *line, const struct description *descr,
+		const int *used, int *attr_ids, int *missing);
+
+/**
+ * @brief Records a new missing value from the learning set.
+ *
+ * @param index Index of attribute
+ * @param set Example set in which to record the missing value
+ * @return Change in flag to record missing value or 0 on error
+ */
+int record_missing(int index, struct example_set *set);
+
 /**
  * @brief Reads the classifier stored in a file.
  *
@@ -227,6 +306,27 @@ struct example_set *read_testing_file(FILE *file,
  */
 struct classifier *read_classifier(FILE *file);
 
+/**
+ * @brief Reads the count of trees of a forest stored in a file.
+ *
+ * A forest is stored as a "forest T" line followed by its T classifiers. A
+ * file without this line holds a single classifier.
+ *
+ * @param file File positioned after the description
+ * @return Count of trees (1 for a single classifier)
+ */
+int read_forest_size(FILE *file);
+
+/**
+ * @brief Finds the attributes tested by a classifier.
+ *
+ * @param cls The classifier
+ * @param used Output: used[i] is set to 1 if attribute i is tested (must be
+ * initialized with 0 by the caller)
+ * @return Count of attributes marked by this call
+ */
+int classifier_attributes(const struct classifier *cls, int *used);
+
 /**
  * @brief Writes the description to a file.
  *
@@ -272,6 +372,19 @@ void write_id3_temp_file(const struct description *descr,
 		const struct classifier *cls,
 		FILE *file);
 
+/**
+ * @brief Writes a forest (the description and all its classifiers) to a
+ * file.
+ *
+ * @param descr Description of the problem
+ * @param trees The classifiers
+ * @param count Count of classifiers
+ * @param file File to write to.
+ */
+void write_forest_file(const struct description *descr,
+		struct classifier *const *trees, int count,
+		FILE *file);
+
 /**
  * @brief Deletes the filtering information associated by each example from
  * the example set.
@@ -284,6 +397,23 @@ void write_id3_temp_file(const struct description *descr,
  */
 void clear_filter_info(const struct example_set *lset);
 
+/**
+ * @brief Makes a deep copy of a description.
+ *
+ * @param descr The description
+ * @return The copy
+ */
+struct description *copy_description(const struct description *descr);
+
+/**
+ * @brief Makes a deep copy of an example set.
+ *
+ * @param set The example set
+ * @param M Count of attributes of an example
+ * @return The copy
+ */
+struct example_set *copy_example_set(const struct example_set *set, int M);
+
 /**
  * @brief Frees the memory allocated to one description.
  *
@@ -302,10 +432,20 @@ void free_description(struct description *ptr);
  */
 void free_example_set(struct example_set *ptr);
 
+/**
+ * @brief Frees one example from an example set.
+ *
+ * Does NOT free the pointer itself.
+ *
+ * @param ptr Pointer to the example.
+ */
+void free_example(struct example *ptr);
+
 /**
  * @brief Frees the id3 tree.
  *
- * Must be called with the root of the tree.
+ * Must be called with the root of the tree. A shared node is freed only when
+ * its last parent is freed.
  *
  * @param ptr Pointer to root.
  */
@@ -338,5 +478,20 @@ void *free_and_set_NULL(void *ptr);
  */
 int get_double_min(double *v, int size);
 
+/**
+ * @brief Runs tasks on several threads.
+ *
+ * The threads take the tasks in order, from a shared counter. If a thread
+ * cannot be created the calling thread runs the tasks left with the
+ * threads already started.
+ *
+ * @param jobs Count of threads
+ * @param count Count of tasks
+ * @param task Function running the task with a given index
+ * @param arg First argument of task
+ */
+void run_tasks(int jobs, int count, void (*task)(void *arg, int index),
+		void *arg);
+
 #endif
 
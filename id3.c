@@ -22,8 +22,12 @@
  */
 
 #include "globals.h"
+#include "id3cv.h"
+#include "id3forest.h"
 #include "id3graph.h"
 #include "id3learn.h"
+#include "id3serve.h"
+#include "id3sweep.h"
 #include "id3test.h"
 
 /**
@@ -56,8 +60,12 @@ static void usage()
 	fprintf(stderr, "./id3 CMD [OPTIONS] FILES\n"
 			"\tCMD can be one of:\n"
 			"\t\tl - learn a classification,\n"
+			"\t\tforest - learn a forest of classifications,\n"
+			"\t\tsweep - learn with several options and compare,\n"
 			"\t\tg - output classification graph,\n"
-			"\t\tc - classify a set of examples.\n"
+			"\t\tc - classify a set of examples,\n"
+			"\t\tcv - estimate the accuracy of learning,\n"
+			"\t\tserve - answer classification requests.\n"
 			"\n"
 			"\tLearning options and arguments:\n"
 			"\t\tFILES = ATTRFILE LEARNFILE ID3FILE(output)\n"
@@ -65,9 +73,37 @@ static void usage()
 			"\t\t\tHandling numeric attributes (one of):\n"
 			"\t\t\t\t-ndiv - divide in two only once (default)\n"
 			"\t\t\t\t-nfull - full handling\n"
+			"\t\t\t\t-nloc - divide in two at each node\n"
 			"\t\t\tHandling missing attributes (one of):\n"
 			"\t\t\t\t-mmaj - replace with most frequent (default)\n"
 			"\t\t\t\t-mprb - use probability theory\n"
+			"\t\t\t-d - share identical subtrees\n"
+			"\t\t\t-o - learn an oblivious tree (the nodes of a\n"
+			"\t\t\t\tlevel test the same attribute, can't be\n"
+			"\t\t\t\tused with -nloc)\n"
+			"\t\t\tPruning the learned tree (one of):\n"
+			"\t\t\t\t-pcol - collapse nodes giving one class\n"
+			"\t\t\t\t-ppes - pessimistic error pruning\n"
+			"\t\t\t\t-prep - reduced error pruning, needs\n"
+			"\t\t\t\t\t-hHOLDOUT - set of examples used to\n"
+			"\t\t\t\t\tmeasure the errors (as LEARNFILE)\n"
+			"\t\t\t-lD - stop at depth D, the nodes there give\n"
+			"\t\t\t\ttheir majority class (default no limit)\n"
+			"\t\t\t-jN - prepare N numeric attributes at once\n"
+			"\t\t\t\t(default 1)\n"
+			"\n"
+			"\tForest learning options and arguments:\n"
+			"\t\tFILES = ATTRFILE LEARNFILE ID3FILE(output)\n"
+			"\t\tOPTIONS:\n"
+			"\t\t\t-ndiv, -nfull, -nloc, -mmaj, -mprb - as for\n"
+			"\t\t\t\tlearning\n"
+			"\t\t\t-tT - learn T trees (default 10)\n"
+			"\t\t\t-aA - test A random attributes at each node\n"
+			"\t\t\t\t(default square root of attribute count)\n"
+			"\t\t\t-sS - seed of the random samples (default 1)\n"
+			"\t\t\t-jN - learn using N threads (default 1)\n"
+			"\t\tThe forest is used by c, classifying by majority\n"
+			"\t\tvote (-r and -p can't be used with a forest)\n"
 			"\n"
 			"\tGraph output options and arguments:\n"
 			"\t\tFILES = ID3FILE [OUTFILE(output)]\n"
@@ -76,10 +112,53 @@ static void usage()
 			"\t\t\t-gascii - display in ASCII art (default)\n"
 			"\t\t\t-gdot - display using Dot\n"
 			"\t\t\t-gscheme - display Scheme-like (Lisp-like)\n"
+			"\t\t\t-gc - output a C classify function\n"
 			"\n"
 			"\tClassification options and arguments:\n"
 			"\t\tFILES = ID3FILE TESTFILE [OUTFILE(output)]\n"
+			"\t\t\tTESTFILE can be - for stdin\n"
 			"\t\t\tOUTFILE can be - (or missing) for stdout\n"
+			"\t\tFILES = ID3FILE -fLIST\n"
+			"\t\t\tLIST has a TESTFILE OUTFILE pair on each line\n"
+			"\t\tOPTIONS:\n"
+			"\t\t\t-s - classify each example as soon as it is read\n"
+			"\t\t\t-jN - classify using N threads (default 1),\n"
+			"\t\t\t\tor N files at once with -f\n"
+			"\t\t\t-b - classify groups of examples at once\n"
+			"\t\t\t-cN - remember the classes of N recent examples\n"
+			"\t\t\t-rPROFILE - record the visits of the tree nodes\n"
+			"\t\t\t-pPROFILE - lay out the tree using a profile\n"
+			"\t\t\t\t-r can't be used with -b or -c,\n"
+			"\t\t\t\t-p can't be used with -b\n"
+			"\n"
+			"\tSweep options and arguments:\n"
+			"\t\tFILES = ATTRFILE LEARNFILE PREFIX\n"
+			"\t\t\tthe classifiers are written to files named\n"
+			"\t\t\tPREFIX_NUM_MISS_PRUNE (e.g. dump_div_maj_none)\n"
+			"\t\tOPTIONS:\n"
+			"\t\t\t-hHOLDOUT - set of examples used to compare\n"
+			"\t\t\t\tthe classifiers (required)\n"
+			"\t\t\t-ndiv, -nfull, -nloc, -mmaj, -mprb, -pcol,\n"
+			"\t\t\t-ppes, -prep - as for learning, several\n"
+			"\t\t\t\tvalues of an option can be given (default\n"
+			"\t\t\t\tall of them)\n"
+			"\t\t\t-pnone - don't prune\n"
+			"\t\t\t-lD - as for learning, several values can be\n"
+			"\t\t\t\tgiven (-l0 for no limit, the default);\n"
+			"\t\t\t\tthe files of limited trees get a _D suffix\n"
+			"\t\t\t-jN - learn using N threads (default 1)\n"
+			"\n"
+			"\tCross-validation options and arguments:\n"
+			"\t\tFILES = ATTRFILE LEARNFILE\n"
+			"\t\tOPTIONS:\n"
+			"\t\t\t-ndiv, -nfull, -nloc, -mmaj, -mprb - as for\n"
+			"\t\t\t\tlearning\n"
+			"\t\t\t-kK - use K folds (default 10)\n"
+			"\t\t\t-jN - do N folds at once (default 1)\n"
+			"\n"
+			"\tServer arguments:\n"
+			"\t\tFILES = ID3FILE SOCKET\n"
+			"\t\t\tSOCKET is the path of a Unix domain socket\n"
 		);
 	exit(EXIT_FAILURE);
 }
@@ -89,31 +168,60 @@ static void usage()
  */
 static void learning_instance(int argc, char **argv)
 {
-	int num_handle, missing_handle;
-	char *attr_file, *learn_file, *id3_file;
+	char *attr_file, *learn_file, *id3_file, *holdout_file;
 	FILE *attr, *learn, *id3;
-	int i, status;
+	struct learn_options opts;
+	int i, status, holdout;
 
-	if (argc < 5 || argc > 7)
+	if (argc < 5 || argc > 13)
 		usage();
 
-	num_handle = UNKNOWN_VALUE;
-	missing_handle = UNKNOWN_VALUE;
+	opts.num_handle = UNKNOWN_VALUE;
+	opts.missing_handle = UNKNOWN_VALUE;
+	opts.dag = UNKNOWN_VALUE;
+	opts.oblivious = UNKNOWN_VALUE;
+	opts.prune = UNKNOWN_VALUE;
+	opts.max_depth = UNKNOWN_VALUE;
+	opts.jobs = UNKNOWN_VALUE;
+	opts.holdout = NULL;
+	holdout = UNKNOWN_VALUE;
+	holdout_file = NULL;
 	attr_file = NULL;
 	learn_file = NULL;
 	id3_file = NULL;
 
 	for (i = 2; i < argc; i++)
 		if (argv[i][0] == '-')/* option */
-			if (SETS(num_handle, "-ndiv"))
-				num_handle = NUM_DIV;
-			else if (SETS(num_handle, "-nfull"))
-				num_handle = NUM_FULL;
-			else if (SETS(missing_handle, "-mmaj"))
-				missing_handle = MISS_MAJ;
-			else if (SETS(missing_handle, "-mprb"))
-				missing_handle = MISS_PRB;
-			else
+			if (SETS(opts.num_handle, "-ndiv"))
+				opts.num_handle = NUM_DIV;
+			else if (SETS(opts.num_handle, "-nfull"))
+				opts.num_handle = NUM_FULL;
+			else if (SETS(opts.num_handle, "-nloc"))
+				opts.num_handle = NUM_LOCAL;
+			else if (SETS(opts.missing_handle, "-mmaj"))
+				opts.missing_handle = MISS_MAJ;
+			else if (SETS(opts.missing_handle, "-mprb"))
+				opts.missing_handle = MISS_PRB;
+			else if (SETS(opts.dag, "-d"))
+				opts.dag = 1;
+			else if (SETS(opts.oblivious, "-o"))
+				opts.oblivious = 1;
+			else if (SETS(opts.prune, "-pcol"))
+				opts.prune = PRUNE_COL;
+			else if (SETS(opts.prune, "-ppes"))
+				opts.prune = PRUNE_PES;
+			else if (SETS(opts.prune, "-prep"))
+				opts.prune = PRUNE_REP;
+			else if (SETS(opts.max_depth, "-l")) {
+				opts.max_depth = atoi(argv[i] + 2);
+				CHECK(opts.max_depth > 0, fail);
+			} else if (SETS(opts.jobs, "-j")) {
+				opts.jobs = atoi(argv[i] + 2);
+				CHECK(opts.jobs > 0, fail);
+			} else if (SETS(holdout, "-h") && argv[i][2]) {
+				holdout = 1;
+				holdout_file = strdup(argv[i] + 2);
+			} else
 				goto fail;
 		else if (attr_file == NULL)
 			attr_file = strdup(argv[i]);
@@ -127,8 +235,136 @@ static void learning_instance(int argc, char **argv)
 	CHECK(id3_file != NULL, fail);
 	CHECK(learn_file != NULL, fail);
 
-	SET_DEFAULT(num_handle, NUM_DIV);
-	SET_DEFAULT(missing_handle, MISS_MAJ);
+	SET_DEFAULT(opts.num_handle, NUM_DIV);
+	SET_DEFAULT(opts.missing_handle, MISS_MAJ);
+	SET_DEFAULT(opts.dag, 0);
+	SET_DEFAULT(opts.oblivious, 0);
+	SET_DEFAULT(opts.prune, PRUNE_NONE);
+	SET_DEFAULT(opts.max_depth, 0);
+	SET_DEFAULT(opts.jobs, 1);
+	CHECK((opts.prune == PRUNE_REP) == (holdout_file != NULL), fail);
+	CHECK(!opts.oblivious || opts.num_handle != NUM_LOCAL, fail);
+
+	if (holdout_file != NULL) {
+		opts.holdout = fopen(holdout_file, "r");
+		if (opts.holdout == NULL) {
+			perror("Cannot open holdout file");
+			goto fail;
+		}
+	}
+
+	attr = fopen(attr_file, "r");
+	if (attr == NULL) {
+		perror("Cannot open attribute file");
+		goto fail;
+	}
+	free(attr_file);
+
+	learn = fopen(learn_file, "r");
+	if (learn == NULL) {
+		perror("Cannot open learn file");
+		fclose(attr);
+		goto fail;
+	}
+	free(learn_file);
+
+	id3 = fopen(id3_file, "w");
+	if (id3 == NULL) {
+		perror("Cannot open output file");
+		fclose(learn);
+		fclose(attr);
+		goto fail;
+	}
+	free(id3_file);
+
+	status = id3_learn_bootstrap_file(&opts, attr, learn, id3);
+	if (status)
+		perror("Error while learning");
+
+	fclose(attr);
+	fclose(learn);
+	fclose(id3);
+	if (opts.holdout)
+		fclose(opts.holdout);
+	free(holdout_file);
+
+	exit(status);
+fail:
+	free_and_set_NULL(attr_file);
+	free_and_set_NULL(learn_file);
+	free_and_set_NULL(id3_file);
+	free_and_set_NULL(holdout_file);
+	usage();
+}
+
+/**
+ * @brief Parses the cmd line for the case when we wish to learn a forest of
+ * classifiers.
+ */
+static void forest_instance(int argc, char **argv)
+{
+	char *attr_file, *learn_file, *id3_file;
+	FILE *attr, *learn, *id3;
+	struct forest_options opts;
+	int i, status, seed;
+
+	if (argc < 5 || argc > 11)
+		usage();
+
+	opts.num_handle = UNKNOWN_VALUE;
+	opts.missing_handle = UNKNOWN_VALUE;
+	opts.trees = UNKNOWN_VALUE;
+	opts.features = UNKNOWN_VALUE;
+	opts.jobs = UNKNOWN_VALUE;
+	seed = UNKNOWN_VALUE;
+	attr_file = NULL;
+	learn_file = NULL;
+	id3_file = NULL;
+
+	for (i = 2; i < argc; i++)
+		if (argv[i][0] == '-')/* option */
+			if (SETS(opts.num_handle, "-ndiv"))
+				opts.num_handle = NUM_DIV;
+			else if (SETS(opts.num_handle, "-nfull"))
+				opts.num_handle = NUM_FULL;
+			else if (SETS(opts.num_handle, "-nloc"))
+				opts.num_handle = NUM_LOCAL;
+			else if (SETS(opts.missing_handle, "-mmaj"))
+				opts.missing_handle = MISS_MAJ;
+			else if (SETS(opts.missing_handle, "-mprb"))
+				opts.missing_handle = MISS_PRB;
+			else if (SETS(opts.trees, "-t")) {
+				opts.trees = atoi(argv[i] + 2);
+				CHECK(opts.trees > 0, fail);
+			} else if (SETS(opts.features, "-a")) {
+				opts.features = atoi(argv[i] + 2);
+				CHECK(opts.features > 0, fail);
+			} else if (SETS(seed, "-s")) {
+				seed = atoi(argv[i] + 2);
+				CHECK(seed >= 0, fail);
+			} else if (SETS(opts.jobs, "-j")) {
+				opts.jobs = atoi(argv[i] + 2);
+				CHECK(opts.jobs > 0, fail);
+			} else
+				goto fail;
+		else if (attr_file == NULL)
+			attr_file = strdup(argv[i]);
+		else if (learn_file == NULL)
+			learn_file = strdup(argv[i]);
+		else if (id3_file == NULL)
+			id3_file = strdup(argv[i]);
+		else
+			goto fail;
+
+	CHECK(id3_file != NULL, fail);
+
+	SET_DEFAULT(opts.num_handle, NUM_DIV);
+	SET_DEFAULT(opts.missing_handle, MISS_MAJ);
+	SET_DEFAULT(opts.trees, 10);
+	SET_DEFAULT(opts.features, 0);
+	SET_DEFAULT(opts.jobs, 1);
+	SET_DEFAULT(seed, 1);
+	opts.seed = seed;
 
 	attr = fopen(attr_file, "r");
 	if (attr == NULL) {
@@ -154,8 +390,7 @@ static void learning_instance(int argc, char **argv)
 	}
 	free(id3_file);
 
-	status = id3_learn_bootstrap_file(num_handle, missing_handle, attr,
-			learn, id3);
+	status = id3_forest_bootstrap_file(&opts, attr, learn, id3);
 	if (status)
 		perror("Error while learning");
 
@@ -202,6 +437,8 @@ static void graphing_instance(int argc, char **argv)
 				graph_mode = TREE_DOT;
 			else if (SETS(graph_mode, "-gscheme"))
 				graph_mode = TREE_SCHEME;
+			else if (SETS(graph_mode, "-gc"))
+				graph_mode = TREE_C;
 			else
 				goto fail;
 		else if (id3_file == NULL)
@@ -248,25 +485,79 @@ fail:
 	usage();
 }
 
+/**
+ * @brief Closes the profile files used while classifying.
+ *
+ * @param opts Classification options
+ */
+static void close_profiles(struct test_options *opts)
+{
+	if (opts->layout)
+		fclose(opts->layout);
+	if (opts->record)
+		fclose(opts->record);
+	opts->layout = NULL;
+	opts->record = NULL;
+}
+
 /**
  * @brief Parses the cmd line for the case when we wish to represent an id3
  * tree corresponding to a classifier.
  */
 static void classifying_instance(int argc, char **argv)
 {
-	char *id3_file, *test_file, *out_file;
+	char *id3_file, *test_file, *out_file, *list_file, *layout_file,
+	     *record_file;
 	FILE *id3, *out, *test;
-	int i, status;
+	struct test_options opts;
+	int i, status, list, layout, record;
 
-	if (argc < 4 || argc > 5)
+	if (argc < 4 || argc > 11)
 		usage();
 
 	id3_file = NULL;
 	test_file = NULL;
 	out_file = NULL;
+	list_file = NULL;
+	layout_file = NULL;
+	record_file = NULL;
+	list = UNKNOWN_VALUE;
+	layout = UNKNOWN_VALUE;
+	record = UNKNOWN_VALUE;
+	opts.layout = NULL;
+	opts.record = NULL;
+	opts.stream = UNKNOWN_VALUE;
+	opts.jobs = UNKNOWN_VALUE;
+	opts.batch = UNKNOWN_VALUE;
+	opts.cache = UNKNOWN_VALUE;
 
 	for (i = 2; i < argc; i++)
-		if (id3_file == NULL)
+		if (argv[i][0] == '-' && argv[i][1] != '\0') /* option */
+			if (SETS(opts.stream, "-s"))
+				opts.stream = 1;
+			else if (SETS(opts.jobs, "-j")) {
+				opts.jobs = atoi(argv[i] + 2);
+				CHECK(opts.jobs > 0, fail);
+			} else if (SETS(opts.batch, "-b"))
+				opts.batch = 1;
+			else if (SETS(opts.cache, "-c")) {
+				opts.cache = atoi(argv[i] + 2);
+				CHECK(opts.cache > 0, fail);
+			} else if (SETS(list, "-f")) {
+				list = 1;
+				list_file = argv[i] + 2;
+				CHECK(*list_file != '\0', fail);
+			} else if (SETS(layout, "-p")) {
+				layout = 1;
+				layout_file = argv[i] + 2;
+				CHECK(*layout_file != '\0', fail);
+			} else if (SETS(record, "-r")) {
+				record = 1;
+				record_file = argv[i] + 2;
+				CHECK(*record_file != '\0', fail);
+			} else
+				goto fail;
+		else if (id3_file == NULL)
 			id3_file = strdup(argv[i]);
 		else if (test_file == NULL)
 			test_file = strdup(argv[i]);
@@ -275,20 +566,67 @@ static void classifying_instance(int argc, char **argv)
 		else
 			goto fail;
 
+	CHECK(id3_file != NULL, fail);
+	CHECK((test_file != NULL) != (list_file != NULL), fail);
+	SET_DEFAULT(opts.stream, 0);
+	SET_DEFAULT(opts.jobs, 1);
+	SET_DEFAULT(opts.batch, 0);
+	SET_DEFAULT(opts.cache, 0);
+	CHECK(record_file == NULL || (!opts.batch && !opts.cache), fail);
+	CHECK(layout_file == NULL || !opts.batch, fail);
+
+	if (layout_file != NULL) {
+		opts.layout = fopen(layout_file, "r");
+		if (opts.layout == NULL) {
+			perror("Cannot open profile file");
+			goto fail;
+		}
+	}
+	if (record_file != NULL) {
+		opts.record = fopen(record_file, "w");
+		if (opts.record == NULL) {
+			perror("Cannot open profile file");
+			close_profiles(&opts);
+			goto fail;
+		}
+	}
+
 	id3 = fopen(id3_file, "r");
 	if (id3 == NULL) {
 		perror("Cannot open classifier file");
+		close_profiles(&opts);
 		goto fail;
 	}
 	free(id3_file);
 
-	test = fopen(test_file, "r");
-	if (test == NULL) {
-		perror("Cannot open test file");
+	if (list_file != NULL) {
+		test = fopen(list_file, "r");
+		if (test == NULL) {
+			perror("Cannot open list file");
+			close_profiles(&opts);
+			fclose(id3);
+			exit(EXIT_FAILURE);
+		}
+		status = id3_test_list(id3, test, &opts);
+		if (status)
+			perror("Error while testing");
+		close_profiles(&opts);
+		fclose(test);
 		fclose(id3);
-		goto fail;
+		exit(status);
+	}
+
+	if (strncmp(test_file, "-", 2) == 0)
+		test = stdin;
+	else {
+		test = fopen(test_file, "r");
+		if (test == NULL) {
+			perror("Cannot open test file");
+			close_profiles(&opts);
+			fclose(id3);
+			goto fail;
+		}
 	}
-	free(test_file);
 
 	if (out_file == NULL || strncmp(out_file, "-", 1) == 0)
 		out = stdout;
@@ -296,18 +634,23 @@ static void classifying_instance(int argc, char **argv)
 		out = fopen(out_file, "w");
 		if (out == NULL) {
 			perror("Cannot open output file");
-			fclose(test);
+			if (test != stdin)
+				fclose(test);
+			close_profiles(&opts);
 			fclose(id3);
 			goto fail;
 		}
 	}
 
-	status = id3_test(id3, test, out);
+	status = id3_test(id3, test, out, &opts);
 	if (status)
 		perror("Error while testing");
 
+	close_profiles(&opts);
 	fclose(id3);
-	fclose(test);
+	if (test != stdin)
+		fclose(test);
+	free(test_file);
 	if (out_file && strncmp(out_file, "-", 1) != 0)
 		fclose(out);
 	free(out_file);
@@ -320,10 +663,257 @@ fail:
 	usage();
 }
 
+/**
+ * @brief Parses the cmd line for the case when we wish to compare several
+ * learning options.
+ */
+static void sweep_instance(int argc, char **argv)
+{
+	char *attr_file, *learn_file, *prefix, *holdout_file;
+	FILE *attr, *learn;
+	struct sweep_options opts;
+	int i, j, status, holdout, depth;
+
+	if (argc < 6 || argc > 16 + SWEEP_DEPTHS)
+		usage();
+
+	opts.num_handles = 0;
+	opts.missing_handles = 0;
+	opts.prunes = 0;
+	opts.depth_count = 0;
+	opts.jobs = UNKNOWN_VALUE;
+	opts.holdout = NULL;
+	holdout = UNKNOWN_VALUE;
+	holdout_file = NULL;
+	attr_file = NULL;
+	learn_file = NULL;
+	prefix = NULL;
+
+	/* values of an option can be repeated, thus they are matched exactly */
+	for (i = 2; i < argc; i++)
+		if (argv[i][0] == '-')/* option */
+			if (strcmp(argv[i], "-ndiv") == 0)
+				opts.num_handles |= SWEEP_BIT(NUM_DIV);
+			else if (strcmp(argv[i], "-nfull") == 0)
+				opts.num_handles |= SWEEP_BIT(NUM_FULL);
+			else if (strcmp(argv[i], "-nloc") == 0)
+				opts.num_handles |= SWEEP_BIT(NUM_LOCAL);
+			else if (strcmp(argv[i], "-mmaj") == 0)
+				opts.missing_handles |= SWEEP_BIT(MISS_MAJ);
+			else if (strcmp(argv[i], "-mprb") == 0)
+				opts.missing_handles |= SWEEP_BIT(MISS_PRB);
+			else if (strcmp(argv[i], "-pnone") == 0)
+				opts.prunes |= SWEEP_BIT(PRUNE_NONE);
+			else if (strcmp(argv[i], "-pcol") == 0)
+				opts.prunes |= SWEEP_BIT(PRUNE_COL);
+			else if (strcmp(argv[i], "-ppes") == 0)
+				opts.prunes |= SWEEP_BIT(PRUNE_PES);
+			else if (strcmp(argv[i], "-prep") == 0)
+				opts.prunes |= SWEEP_BIT(PRUNE_REP);
+			else if (strncmp(argv[i], "-l", 2) == 0 && argv[i][2]) {
+				depth = atoi(argv[i] + 2);
+				CHECK(depth >= 0, fail);
+				for (j = 0; j < opts.depth_count; j++)
+					if (opts.depths[j] == depth)
+						break;
+				SKIPIF(j < opts.depth_count);
+				CHECK(opts.depth_count < SWEEP_DEPTHS, fail);
+				opts.depths[opts.depth_count++] = depth;
+			} else if (SETS(opts.jobs, "-j")) {
+				opts.jobs = atoi(argv[i] + 2);
+				CHECK(opts.jobs > 0, fail);
+			} else if (SETS(holdout, "-h") && argv[i][2]) {
+				holdout = 1;
+				holdout_file = strdup(argv[i] + 2);
+			} else
+				goto fail;
+		else if (attr_file == NULL)
+			attr_file = strdup(argv[i]);
+		else if (learn_file == NULL)
+			learn_file = strdup(argv[i]);
+		else if (prefix == NULL)
+			prefix = strdup(argv[i]);
+		else
+			goto fail;
+
+	CHECK(prefix != NULL, fail);
+	CHECK(holdout_file != NULL, fail);
+
+	if (opts.num_handles == 0)
+		opts.num_handles = SWEEP_BIT(NUM_DIV) | SWEEP_BIT(NUM_FULL) |
+			SWEEP_BIT(NUM_LOCAL);
+	if (opts.missing_handles == 0)
+		opts.missing_handles = SWEEP_BIT(MISS_MAJ) |
+			SWEEP_BIT(MISS_PRB);
+	if (opts.prunes == 0)
+		opts.prunes = SWEEP_BIT(PRUNE_NONE) | SWEEP_BIT(PRUNE_COL) |
+			SWEEP_BIT(PRUNE_PES) | SWEEP_BIT(PRUNE_REP);
+	if (opts.depth_count == 0)
+		opts.depths[opts.depth_count++] = 0;
+	SET_DEFAULT(opts.jobs, 1);
+	opts.prefix = prefix;
+
+	opts.holdout = fopen(holdout_file, "r");
+	if (opts.holdout == NULL) {
+		perror("Cannot open holdout file");
+		goto fail;
+	}
+
+	attr = fopen(attr_file, "r");
+	if (attr == NULL) {
+		perror("Cannot open attribute file");
+		fclose(opts.holdout);
+		goto fail;
+	}
+
+	learn = fopen(learn_file, "r");
+	if (learn == NULL) {
+		perror("Cannot open learn file");
+		fclose(attr);
+		fclose(opts.holdout);
+		goto fail;
+	}
+
+	status = id3_sweep_bootstrap_file(&opts, attr, learn, stdout);
+	if (status)
+		perror("Error while sweeping");
+
+	fclose(attr);
+	fclose(learn);
+	fclose(opts.holdout);
+	free(attr_file);
+	free(learn_file);
+	free(prefix);
+	free(holdout_file);
+
+	exit(status);
+fail:
+	free_and_set_NULL(attr_file);
+	free_and_set_NULL(learn_file);
+	free_and_set_NULL(prefix);
+	free_and_set_NULL(holdout_file);
+	usage();
+}
+
+/**
+ * @brief Parses the cmd line for the case when we wish to cross-validate
+ * the learning process.
+ */
+static void cv_instance(int argc, char **argv)
+{
+	char *attr_file, *learn_file;
+	FILE *attr, *learn;
+	struct cv_options opts;
+	int i, status;
+
+	if (argc < 4 || argc > 8)
+		usage();
+
+	opts.num_handle = UNKNOWN_VALUE;
+	opts.missing_handle = UNKNOWN_VALUE;
+	opts.folds = UNKNOWN_VALUE;
+	opts.jobs = UNKNOWN_VALUE;
+	attr_file = NULL;
+	learn_file = NULL;
+
+	for (i = 2; i < argc; i++)
+		if (argv[i][0] == '-')/* option */
+			if (SETS(opts.num_handle, "-ndiv"))
+				opts.num_handle = NUM_DIV;
+			else if (SETS(opts.num_handle, "-nfull"))
+				opts.num_handle = NUM_FULL;
+			else if (SETS(opts.num_handle, "-nloc"))
+				opts.num_handle = NUM_LOCAL;
+			else if (SETS(opts.missing_handle, "-mmaj"))
+				opts.missing_handle = MISS_MAJ;
+			else if (SETS(opts.missing_handle, "-mprb"))
+				opts.missing_handle = MISS_PRB;
+			else if (SETS(opts.folds, "-k")) {
+				opts.folds = atoi(argv[i] + 2);
+				CHECK(opts.folds > 1, fail);
+			} else if (SETS(opts.jobs, "-j")) {
+				opts.jobs = atoi(argv[i] + 2);
+				CHECK(opts.jobs > 0, fail);
+			} else
+				goto fail;
+		else if (attr_file == NULL)
+			attr_file = strdup(argv[i]);
+		else if (learn_file == NULL)
+			learn_file = strdup(argv[i]);
+		else
+			goto fail;
+
+	CHECK(learn_file != NULL, fail);
+
+	SET_DEFAULT(opts.num_handle, NUM_DIV);
+	SET_DEFAULT(opts.missing_handle, MISS_MAJ);
+	SET_DEFAULT(opts.folds, 10);
+	SET_DEFAULT(opts.jobs, 1);
+
+	attr = fopen(attr_file, "r");
+	if (attr == NULL) {
+		perror("Cannot open attribute file");
+		goto fail;
+	}
+	free(attr_file);
+
+	learn = fopen(learn_file, "r");
+	if (learn == NULL) {
+		perror("Cannot open learn file");
+		fclose(attr);
+		free(learn_file);
+		usage();
+	}
+	free(learn_file);
+
+	status = id3_cv_bootstrap_file(&opts, attr, learn, stdout);
+	if (status)
+		perror("Error while cross-validating");
+
+	fclose(attr);
+	fclose(learn);
+
+	exit(status);
+fail:
+	free_and_set_NULL(attr_file);
+	free_and_set_NULL(learn_file);
+	usage();
+}
+
+/**
+ * @brief Parses the cmd line for the case when we wish to answer
+ * classification requests coming over a socket.
+ */
+static void serving_instance(int argc, char **argv)
+{
+	int status;
+
+	if (argc != 4)
+		usage();
+
+	status = id3_serve(argv[2], argv[3]);
+	if (status)
+		perror("Error while serving");
+
+	exit(status);
+}
+
 int main(int argc, char **argv)
 {
 	CHECK(argc >= 2, exit);
 
+	if (strcmp(argv[1], "serve") == 0)
+		serving_instance(argc, argv);
+
+	if (strcmp(argv[1], "forest") == 0)
+		forest_instance(argc, argv);
+
+	if (strcmp(argv[1], "cv") == 0)
+		cv_instance(argc, argv);
+
+	if (strcmp(argv[1], "sweep") == 0)
+		sweep_instance(argc, argv);
+
 	if (strncmp(argv[1], "l", 1) == 0)
 		learning_instance(argc, argv);
 
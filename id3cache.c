@@ -0,0 +1,107 @@
+/*!
+ * @file id3cache.c
+ * @brief Cache of classification results.
+ * @author Mihai Maruseac (mihai@rosedu.org)
+ *
+ * @section DESCRIPTION
+ * IAUT1: ID3: Cache of classification results.
+ *
+ * Contains the functions used to remember the class given to recently seen
+ * examples, so that repeated examples are not walked through the tree again.
+ *
+ * @section QUOTE
+ * There are only two hard things in Computer Science: cache invalidation and
+ * naming things. (Phil Karlton)
+ *
+ * @bug No known bugs.
+ */
+
+#include "globals.h"
+#include "id3cache.h"
+
+/**
+ * @brief Computes the hash of the key of an example (FNV-1a).
+ *
+ * @param cache The cache
+ * @param attr_ids Attribute values of the example
+ * @return The hash
+ */
+static unsigned cache_hash(const struct leaf_cache *cache,
+		const int *attr_ids);
+
+struct leaf_cache *cache_create(const int *used, int M, int size)
+{
+	struct leaf_cache *cache;
+	unsigned slots;
+	int i;
+
+	cache = calloc(1, sizeof(*cache));
+	cache->attrs = calloc(M, sizeof(cache->attrs[0]));
+	for (i = 0; i < M; i++)
+		if (used[i])
+			cache->attrs[cache->count++] = i;
+
+	for (slots = 1; slots < (unsigned)size; slots <<= 1)
+		;
+	cache->mask = slots - 1;
+	cache->keys = calloc((size_t)slots * cache->count,
+			sizeof(cache->keys[0]));
+	cache->classes = calloc(slots, sizeof(cache->classes[0]));
+	for (i = 0; i < (int)slots; i++)
+		cache->classes[i] = CACHE_MISS;
+	return cache;
+}
+
+unsigned cache_hash(const struct leaf_cache *cache, const int *attr_ids)
+{
+	unsigned h = 2166136261u;
+	int i;
+
+	for (i = 0; i < cache->count; i++) {
+		h ^= (unsigned)attr_ids[cache->attrs[i]];
+		h *= 16777619u;
+	}
+	return h ^ (h >> 16);
+}
+
+int cache_lookup(struct leaf_cache *cache, const int *attr_ids,
+		unsigned *slot)
+{
+	const int *key;
+	int i;
+
+	cache->lookups++;
+	*slot = cache_hash(cache, attr_ids) & cache->mask;
+	CHECK(cache->classes[*slot] != CACHE_MISS, miss);
+
+	key = cache->keys + (size_t)*slot * cache->count;
+	for (i = 0; i < cache->count; i++)
+		CHECK(key[i] == attr_ids[cache->attrs[i]], miss);
+	cache->hits++;
+	return cache->classes[*slot];
+miss:
+	return CACHE_MISS;
+}
+
+void cache_store(struct leaf_cache *cache, unsigned slot,
+		const int *attr_ids, int cls)
+{
+	int *key;
+	int i;
+
+	key = cache->keys + (size_t)slot * cache->count;
+	for (i = 0; i < cache->count; i++)
+		key[i] = attr_ids[cache->attrs[i]];
+	cache->classes[slot] = cls;
+}
+
+void free_cache(struct leaf_cache *ptr)
+{
+	if (ptr == NULL)
+		return;
+
+	free_and_set_NULL(ptr->attrs);
+	free_and_set_NULL(ptr->keys);
+	free_and_set_NULL(ptr->classes);
+	free_and_set_NULL(ptr);
+}
@@ -0,0 +1,89 @@
+/*!
+ * @file id3cache.h
+ * @brief Cache of classification results.
+ * @author Mihai Maruseac (mihai@rosedu.org)
+ *
+ * @section DESCRIPTION
+ * IAUT1: ID3: Cache of classification results.
+ *
+ * Contains the functions used to remember the class given to recently seen
+ * examples, so that repeated examples are not walked through the tree again.
+ *
+ * @section QUOTE
+ * There are only two hard things in Computer Science: cache invalidation and
+ * naming things. (Phil Karlton)
+ *
+ * @bug No known bugs.
+ */
+
+#ifndef _ID3CACHE_H
+#define _ID3CACHE_H
+
+#define CACHE_MISS -2 /**< @brief Returned by cache_lookup on a miss */
+
+/**
+ * @brief Structure representing the cache.
+ *
+ * The cache is direct mapped: the key of an example (the values of the
+ * attributes tested by the tree, the others don't change its class) selects
+ * a single slot, which is overwritten on a miss. A cache is not shared
+ * between threads.
+ */
+struct leaf_cache {
+	/** Count of attributes in the key */
+	int count;
+	/** Indexes of attributes in the key */
+	int *attrs;
+	/** Mask selecting the slot from the hash (count of slots - 1) */
+	unsigned mask;
+	/** Keys stored in slots (count values for each slot) */
+	int *keys;
+	/** Class stored in slots (CACHE_MISS for empty slots) */
+	int *classes;
+	/** Count of lookups */
+	long long lookups;
+	/** Count of lookups finding the class */
+	long long hits;
+};
+
+/**
+ * @brief Creates an empty cache.
+ *
+ * @param used used[i] is not 0 if attribute i is tested by the tree
+ * @param M Count of attributes
+ * @param size Count of slots (rounded up to a power of 2)
+ * @return The cache
+ */
+struct leaf_cache *cache_create(const int *used, int M, int size);
+
+/**
+ * @brief Looks an example up in the cache.
+ *
+ * @param cache The cache
+ * @param attr_ids Attribute values of the example
+ * @param slot Output: slot of the example, to be used by cache_store
+ * @return Id of class (or -1 if unknown) or CACHE_MISS.
+ */
+int cache_lookup(struct leaf_cache *cache, const int *attr_ids,
+		unsigned *slot);
+
+/**
+ * @brief Stores the class of an example in the cache.
+ *
+ * @param cache The cache
+ * @param slot Slot returned by cache_lookup for this example
+ * @param attr_ids Attribute values of the example
+ * @param cls Id of class (or -1)
+ */
+void cache_store(struct leaf_cache *cache, unsigned slot,
+		const int *attr_ids, int cls);
+
+/**
+ * @brief Frees the cache.
+ *
+ * @param ptr Pointer to the cache.
+ */
+void free_cache(struct leaf_cache *ptr);
+
+#endif
+
@@ -0,0 +1,271 @@
+/*!
+ * @file id3cv.c
+ * @brief Cross-validation of the id3 classifier.
+ * @author Mihai Maruseac (mihai@rosedu.org)
+ *
+ * @section DESCRIPTION
+ * IAUT1: ID3: Cross-validation of the id3 classifier.
+ *
+ * Contains the functions used to estimate the accuracy of the classifier
+ * learned with some options, by learning it on parts of the learning set and
+ * testing it on the rest (k-fold cross-validation).
+ *
+ * @section QUOTE
+ * Trust, but verify. (Russian proverb)
+ *
+ * @bug No known bugs.
+ */
+
+#include <time.h>
+
+#include "globals.h"
+#include "id3cv.h"
+#include "id3flat.h"
+#include "id3learn.h"
+#include "id3missing.h"
+
+/**
+ * @brief Result of one fold.
+ */
+struct cv_fold {
+	/** Count of examples of the fold */
+	int count;
+	/** Count of examples of the fold classified correctly */
+	int correct;
+	/** Seconds spent learning */
+	double learn_time;
+	/** Seconds spent testing */
+	double test_time;
+};
+
+/**
+ * @brief Work shared by the threads doing the folds.
+ */
+struct cv_work {
+	/** Options */
+	const struct cv_options *opts;
+	/** The description of the problem (read-only, each fold prepares
+	 * its own copy)
+	 */
+	const struct description *descr;
+	/** The learning set (read-only, each fold prepares its own copy) */
+	const struct example_set *lset;
+	/** Result of each fold */
+	struct cv_fold *folds;
+};
+
+/**
+ * @brief Task doing one fold (see run_tasks).
+ *
+ * @param arg The struct cv_work
+ * @param index Index of fold
+ */
+static void fold_task(void *arg, int index);
+
+/**
+ * @brief Learns the classifier without one fold and tests it on that fold.
+ *
+ * The missing values are filled and the numeric attributes discretized on a
+ * copy of the learning set, from the examples of the other folds only, thus
+ * the classes of the tested examples are never used.
+ *
+ * @param work The cross-validation
+ * @param index Index of the fold
+ * @param fold Output: result of the fold
+ */
+static void do_fold(const struct cv_work *work, int index,
+		struct cv_fold *fold);
+
+/**
+ * @brief Moves the examples of a fold after the other ones.
+ *
+ * The order of the examples is kept inside both parts.
+ *
+ * @param set The example set
+ * @param folds Count of folds
+ * @param index Index of the fold
+ * @return Count of examples of the other folds (the tested examples start
+ * at this index)
+ */
+static int split_fold(struct example_set *set, int folds, int index);
+
+/**
+ * @brief Fills the missing values of the tested examples.
+ *
+ * Each missing value is filled as with MISS_MAJ from the learning examples
+ * (most frequent value, mean for a numeric attribute), whatever the class
+ * of the tested example. A value no learning example knows is left missing.
+ *
+ * @param descr The description of the problem
+ * @param set The example set, split by split_fold
+ * @param count Count of learning examples
+ */
+static void fill_tested(const struct description *descr,
+		struct example_set *set, int count);
+
+/**
+ * @brief Returns the time elapsed since a fixed point, in seconds.
+ *
+ * @return Seconds
+ */
+static double now(void);
+
+int id3_cv_bootstrap_file(const struct cv_options *opts,
+		FILE *attr_file, FILE *learn_file, FILE *out)
+{
+	struct description *descr;
+	struct example_set *lset;
+	struct cv_work work;
+	double start, sum, acc;
+	int i;
+
+	start = now();
+	descr = read_description_file(attr_file);
+	CHECK(descr != NULL, nodescr);
+	lset = read_learning_file(learn_file, descr);
+	CHECK(lset != NULL, nolset);
+	/* each fold must have an example to test and some to learn from */
+	CHECK(lset->N >= opts->folds, fail);
+
+	work.opts = opts;
+	work.descr = descr;
+	work.lset = lset;
+	work.folds = calloc(opts->folds, sizeof(work.folds[0]));
+	run_tasks(opts->jobs, opts->folds, fold_task, &work);
+
+	for (i = 0, sum = 0; i < opts->folds; i++) {
+		acc = DIV(work.folds[i].correct, work.folds[i].count);
+		fprintf(out, "fold %d: %.4f (%d/%d)\n", i + 1, acc,
+				work.folds[i].correct, work.folds[i].count);
+		fprintf(stderr, "fold %d: learned in %.3fms, tested in "
+				"%.3fms\n", i + 1, work.folds[i].learn_time * 1e3,
+				work.folds[i].test_time * 1e3);
+		sum += acc;
+	}
+	fprintf(out, "mean: %.4f\n", sum / opts->folds);
+	fprintf(stderr, "total: %.3fms\n", (now() - start) * 1e3);
+
+	free(work.folds);
+	free_description(descr);
+	free_and_set_NULL(descr);
+	free_example_set(lset);
+	free_and_set_NULL(lset);
+	return EXIT_SUCCESS;
+
+fail:
+	free_example_set(lset);
+	free_and_set_NULL(lset);
+nolset:
+	free_description(descr);
+	free_and_set_NULL(descr);
+nodescr:
+	return set_error(EINVAL);
+}
+
+void fold_task(void *arg, int index)
+{
+	struct cv_work *work = arg;
+
+	do_fold(work, index, &work->folds[index]);
+}
+
+void do_fold(const struct cv_work *work, int index, struct cv_fold *fold)
+{
+	struct description *descr;
+	struct example_set *lset;
+	struct learn_state st;
+	struct classifier *cls;
+	struct flat_tree *tree;
+	int i, N;
+	double start;
+
+	/* filling the missing values and the discretization change both */
+	start = now();
+	descr = copy_description(work->descr);
+	lset = copy_example_set(work->lset, descr->M);
+	N = lset->N;
+	lset->N = split_fold(lset, work->opts->folds, index);
+	fill_tested(descr, lset, lset->N);
+	id3_prepare_set(descr, lset, work->opts->num_handle,
+			work->opts->missing_handle, 1);
+	st.descr = descr;
+	st.lset = lset;
+	st.weight = NULL;
+	st.num_handle = work->opts->num_handle;
+	st.features = 0;
+	st.seed = 0;
+	st.max_depth = 0;
+	cls = id3_learn_tree(&st);
+	tree = flatten_classifier(descr, cls);
+	free_classifier(cls);
+	fold->learn_time = now() - start;
+
+	start = now();
+	for (i = lset->N; i < N; i++) {
+		fold->count++;
+		INCRIF(flat_classify(tree, lset->examples[i]->attr_ids) ==
+				lset->examples[i]->class_id, fold->correct);
+	}
+	fold->test_time = now() - start;
+
+	free_flat_tree(tree);
+	lset->N = N;
+	free_example_set(lset);
+	free_and_set_NULL(lset);
+	free_description(descr);
+	free_and_set_NULL(descr);
+}
+
+int split_fold(struct example_set *set, int folds, int index)
+{
+	struct example **tested;
+	int i, n, t;
+
+	tested = calloc(set->N, sizeof(tested[0]));
+	for (i = 0, n = 0, t = 0; i < set->N; i++)
+		if (i % folds == index)
+			tested[t++] = set->examples[i];
+		else
+			set->examples[n++] = set->examples[i];
+	memcpy(set->examples + n, tested, t * sizeof(tested[0]));
+	free(tested);
+	return n;
+}
+
+void fill_tested(const struct description *descr, struct example_set *set,
+		int count)
+{
+	struct example_set view;
+	int i, j, known, bit;
+
+	/* the learning examples knowing the value, then the tested ones
+	 * missing it: only these are filled
+	 */
+	view = *set;
+	view.examples = calloc(set->N, sizeof(view.examples[0]));
+	for (i = 0; i < set->missing_count; i++) {
+		bit = 1 << i;
+		view.N = 0;
+		for (j = 0; j < set->N; j++)
+			if (!(set->examples[j]->miss & bit) == (j < count))
+				view.examples[view.N++] = set->examples[j];
+		for (j = 0, known = 0; j < view.N; j++)
+			INCRIF(!(view.examples[j]->miss & bit), known);
+		SKIPIF(known == 0);
+		if (descr->attribs[set->missing[i]]->type == NUMERIC)
+			numeric_maj_fill_missing(&view, set->missing[i], i);
+		else
+			discrete_maj_fill_missing(descr, &view,
+					set->missing[i], i);
+	}
+	free(view.examples);
+}
+
+double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
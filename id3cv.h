@@ -0,0 +1,61 @@
+/*!
+ * @file id3cv.h
+ * @brief Cross-validation of the id3 classifier.
+ * @author Mihai Maruseac (mihai@rosedu.org)
+ *
+ * @section DESCRIPTION
+ * IAUT1: ID3: Cross-validation of the id3 classifier.
+ *
+ * Contains the functions used to estimate the accuracy of the classifier
+ * learned with some options, by learning it on parts of the learning set and
+ * testing it on the rest (k-fold cross-validation).
+ *
+ * @section QUOTE
+ * Trust, but verify. (Russian proverb)
+ *
+ * @bug No known bugs.
+ */
+
+#ifndef _ID3CV_H
+#define _ID3CV_H
+
+#include "globals.h"
+
+/**
+ * @brief Options of the cross-validation.
+ */
+struct cv_options {
+	/** How to handle numeric arguments */
+	int num_handle;
+	/** How to handle missing arguments */
+	int missing_handle;
+	/** Count of folds */
+	int folds;
+	/** Count of threads learning and testing folds */
+	int jobs;
+};
+
+/**
+ * @brief Bootstraps the cross-validation by reading data from the input
+ * files.
+ *
+ * The learning set is read only once. Example i belongs to fold
+ * i mod opts->folds. For each fold, the missing values are filled and the
+ * numeric attributes discretized on a copy of the set, from the other folds
+ * only, then a classifier is learned from the other folds and tested on the
+ * fold. Up to opts->jobs folds are done at the same time.
+ *
+ * The accuracy of each fold and the mean accuracy are written to out, the
+ * time taken by each fold to stderr.
+ *
+ * @param opts Options.
+ * @param attr_file File containing the attribute description.
+ * @param learn_file File containing the example set.
+ * @param out File to write the accuracies to.
+ * @return The exit code for the cross-validation.
+ */
+int id3_cv_bootstrap_file(const struct cv_options *opts,
+		FILE *attr_file, FILE *learn_file, FILE *out);
+
+#endif
+
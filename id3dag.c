@@ -0,0 +1,164 @@
+/*!
+ * @file id3dag.c
+ * @brief Sharing of identical subtrees of an id3 classifier.
+ * @author Mihai Maruseac (mihai@rosedu.org)
+ *
+ * @section DESCRIPTION
+ * IAUT1: ID3: Sharing of identical subtrees of an id3 classifier.
+ *
+ * Contains the functions used to turn an id3 tree into a directed acyclic
+ * graph, by keeping a single copy of each group of identical subtrees.
+ *
+ * @section QUOTE
+ * Simplicity is prerequisite for reliability. (Dijkstra)
+ *
+ * @bug No known bugs.
+ */
+
+#include <stdint.h>
+
+#include "globals.h"
+#include "id3dag.h"
+
+/**
+ * @brief Structure representing the set of distinct subtrees found so far.
+ *
+ * Open addressing hash table, keyed by the structure of the node.
+ */
+struct subtree_table {
+	/** Count of slots (a power of 2) */
+	unsigned size;
+	/** Count of used slots */
+	unsigned count;
+	/** Node stored in each slot (NULL if empty) */
+	struct classifier **nodes;
+};
+
+/**
+ * @brief Replaces the identical subtrees of a node by shared ones.
+ *
+ * The branches are processed first, thus two nodes are identical if they
+ * have the same id, values and (already shared) branches.
+ *
+ * @param table Distinct subtrees found so far
+ * @param cls The node
+ * @return The node or an identical one found before
+ */
+static struct classifier *share_node(struct subtree_table *table,
+		struct classifier *cls);
+
+/**
+ * @brief Computes the hash of a node (FNV-1a), from its id, values and
+ * branches.
+ *
+ * @param cls The node
+ * @return The hash
+ */
+static unsigned node_hash(const struct classifier *cls);
+
+/**
+ * @brief Tests if two nodes are identical.
+ *
+ * @param a First node
+ * @param b Second node
+ * @return 1 if the nodes are identical, 0 otherwise
+ */
+static int node_equal(const struct classifier *a, const struct classifier *b);
+
+/**
+ * @brief Doubles the count of slots of the table.
+ *
+ * @param table The table
+ */
+static void table_grow(struct subtree_table *table);
+
+struct classifier *share_subtrees(struct classifier *cls)
+{
+	struct subtree_table table;
+
+	table.size = 64;
+	table.count = 0;
+	table.nodes = calloc(table.size, sizeof(table.nodes[0]));
+	cls = share_node(&table, cls);
+	free(table.nodes);
+	return cls;
+}
+
+struct classifier *share_node(struct subtree_table *table,
+		struct classifier *cls)
+{
+	struct classifier *found;
+	unsigned slot;
+	int i;
+
+	if (cls == NULL)
+		return NULL;
+
+	for (i = 0; i < cls->C; i++)
+		cls->cls[i] = share_node(table, cls->cls[i]);
+
+	if (2 * (table->count + 1) > table->size)
+		table_grow(table);
+	slot = node_hash(cls) & (table->size - 1);
+	while ((found = table->nodes[slot]) != NULL) {
+		if (found == cls)
+			return cls;
+		if (node_equal(found, cls)) {
+			/* the branches of cls are shared with found */
+			found->shared++;
+			free_classifier(cls);
+			return found;
+		}
+		slot = (slot + 1) & (table->size - 1);
+	}
+
+	table->nodes[slot] = cls;
+	table->count++;
+	return cls;
+}
+
+unsigned node_hash(const struct classifier *cls)
+{
+	unsigned h = 2166136261u;
+	uintptr_t p;
+	int i;
+
+	h = (h ^ (unsigned)cls->id) * 16777619u;
+	h = (h ^ (unsigned)cls->C) * 16777619u;
+	for (i = 0; i < cls->C; i++) {
+		p = (uintptr_t)cls->cls[i];
+		h = (h ^ (unsigned)cls->values[i]) * 16777619u;
+		h = (h ^ (unsigned)(p >> 4)) * 16777619u;
+		h = (h ^ (unsigned)(p >> 36)) * 16777619u;
+	}
+	return h ^ (h >> 16);
+}
+
+int node_equal(const struct classifier *a, const struct classifier *b)
+{
+	int i;
+
+	if (a->id != b->id || a->C != b->C)
+		return 0;
+	for (i = 0; i < a->C; i++)
+		if (a->values[i] != b->values[i] || a->cls[i] != b->cls[i])
+			return 0;
+	return 1;
+}
+
+void table_grow(struct subtree_table *table)
+{
+	struct classifier **old = table->nodes;
+	unsigned i, size = table->size, slot;
+
+	table->size *= 2;
+	table->nodes = calloc(table->size, sizeof(table->nodes[0]));
+	for (i = 0; i < size; i++) {
+		SKIPIF(old[i] == NULL);
+		slot = node_hash(old[i]) & (table->size - 1);
+		while (table->nodes[slot] != NULL)
+			slot = (slot + 1) & (table->size - 1);
+		table->nodes[slot] = old[i];
+	}
+	free(old);
+}
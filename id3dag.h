@@ -0,0 +1,37 @@
+/*!
+ * @file id3dag.h
+ * @brief Sharing of identical subtrees of an id3 classifier.
+ * @author Mihai Maruseac (mihai@rosedu.org)
+ *
+ * @section DESCRIPTION
+ * IAUT1: ID3: Sharing of identical subtrees of an id3 classifier.
+ *
+ * Contains the functions used to turn an id3 tree into a directed acyclic
+ * graph, by keeping a single copy of each group of identical subtrees.
+ *
+ * @section QUOTE
+ * Simplicity is prerequisite for reliability. (Dijkstra)
+ *
+ * @bug No known bugs.
+ */
+
+#ifndef _ID3DAG_H
+#define _ID3DAG_H
+
+#include "globals.h"
+
+/**
+ * @brief Shares the identical subtrees of a classifier.
+ *
+ * Two subtrees are identical if they test the same attribute with the same
+ * values and their branches are identical (or, for leaves, if they give the
+ * same class); the tags are not compared. All copies but the first one are
+ * freed and replaced by the first one, whose shared count is updated.
+ *
+ * @param cls The classifier (may be already partially shared)
+ * @return The classifier (the root is never replaced)
+ */
+struct classifier *share_subtrees(struct classifier *cls);
+
+#endif
+
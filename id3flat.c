@@ -0,0 +1,1058 @@
+/*!
+ * @file id3flat.c
+ * @brief Compiled (flattened) form of an id3 classifier.
+ * @author Mihai Maruseac (mihai@rosedu.org)
+ *
+ * @section DESCRIPTION
+ * IAUT1: ID3: Compiled (flattened) form of an id3 classifier.
+ *
+ * Contains the functions used to transform an id3 tree into a contiguous
+ * vector of nodes, faster to walk when classifying many examples.
+ *
+ * @section QUOTE
+ * Premature optimization is the root of all evil. (Donald Knuth)
+ *
+ * @bug No known bugs.
+ */
+
+#include <stdint.h>
+
+#include "globals.h"
+#include "id3flat.h"
+
+#if defined(__GNUC__) && defined(__x86_64__) && !defined(NO_AVX2)
+/**
+ * @brief Defined if the AVX2 batch kernel is compiled in (it is used only if
+ * the processor supports it).
+ */
+#define BATCH_AVX2
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief Structure remembering where the shared nodes of a classifier were
+ * compiled, so that their subtrees are compiled only once.
+ *
+ * Open addressing hash table, keyed by the address of the node.
+ */
+struct node_map {
+	/** Count of slots (a power of 2) */
+	unsigned size;
+	/** Count of used slots */
+	unsigned count;
+	/** Node stored in each slot (NULL if empty) */
+	const struct classifier **keys;
+	/** Index of the compiled node */
+	int *index;
+	/** Height of the compiled subtree (batch trees only) */
+	int *height;
+};
+
+/**
+ * @brief Initializes an empty map.
+ *
+ * @param map The map
+ */
+static void map_init(struct node_map *map);
+
+/**
+ * @brief Looks a node up in a map.
+ *
+ * @param map The map
+ * @param cls The node
+ * @return Slot of the node or -1 if not found
+ */
+static int map_find(const struct node_map *map, const struct classifier *cls);
+
+/**
+ * @brief Adds a node to a map.
+ *
+ * @param map The map
+ * @param cls The node (not already in the map)
+ * @param index Index of the compiled node
+ * @param height Height of the compiled subtree
+ */
+static void map_add(struct node_map *map, const struct classifier *cls,
+		int index, int height);
+
+/**
+ * @brief Frees the vectors of a map.
+ *
+ * @param map The map
+ */
+static void map_free(struct node_map *map);
+
+/**
+ * @brief Counts the nodes and the thresholds of the flattened form of a
+ * classifier.
+ *
+ * Discrete nodes are counted with one child for each value of the
+ * attribute. The subtree of a shared node is counted only once.
+ *
+ * @param descr The description of the problem
+ * @param cls The classifier
+ * @param map Shared nodes already counted
+ * @param values Incremented with the count of thresholds
+ * @return Count of nodes
+ */
+static int count_nodes(const struct description *descr,
+		const struct classifier *cls, struct node_map *map,
+		int *values);
+
+/**
+ * @brief Allocates a flattened tree, with room for all nodes of a
+ * classifier.
+ *
+ * @param descr The description of the problem
+ * @param cls The classifier
+ * @return The flattened tree
+ */
+static struct flat_tree *flat_alloc(const struct description *descr,
+		const struct classifier *cls);
+
+/**
+ * @brief Fills one node of the flattened tree, reserving its children.
+ *
+ * A shared node which was already filled is copied, thus it points to the
+ * same children.
+ *
+ * @param descr The description of the problem
+ * @param tree The flattened tree
+ * @param slots Classifier of each node (NULL for unknown class leaves); the
+ * classifiers of the children are stored here
+ * @param map Shared nodes already filled
+ * @param idx Index of node to fill
+ * @param tail Index of first free node (updated)
+ * @param v Index of first free value (updated)
+ * @return 1 if the node is a copy (no children reserved), 0 otherwise
+ */
+static int flat_fill(const struct description *descr,
+		struct flat_tree *tree, const struct classifier **slots,
+		struct node_map *map, int idx, int *tail, int *v);
+
+/**
+ * @brief Returns the count of visits of a node, as given by a profile.
+ *
+ * @param profile The profile
+ * @param cls The classifier node (NULL for unknown class)
+ * @return Count of visits
+ */
+static long long profile_visits(const struct flat_profile *profile,
+		const struct classifier *cls);
+
+/**
+ * @brief Returns the branch of a discrete node taken by a value.
+ *
+ * The first branch having the value (or CLS_ANY) is taken, as in a linear
+ * scan.
+ *
+ * @param cls The discrete node
+ * @param v The value
+ * @return The branch or NULL (unknown class) if there is none
+ */
+static const struct classifier *discrete_branch(const struct classifier *cls,
+		int v);
+
+/**
+ * @brief Tests if the thresholds of a numeric node are in ascending order.
+ *
+ * @param cls The classifier
+ * @return 1 if sorted, 0 otherwise
+ */
+static int sorted_thresholds(const struct classifier *cls);
+
+/**
+ * @brief Returns the branch of a numeric node, using a binary search.
+ *
+ * The result is the count of thresholds less than or equal to the value,
+ * computed without branches (except the loop).
+ *
+ * @param values Thresholds (in ascending order)
+ * @param n Count of thresholds (at least 1)
+ * @param v Value of the attribute
+ * @return Index of branch
+ */
+static int bsearch_branch(const int *values, int n, int v);
+
+/**
+ * @brief Reserves consecutive nodes in the binary tree.
+ *
+ * @param tree The binary tree
+ * @param n Count of nodes
+ * @return Index of first reserved node
+ */
+static int batch_reserve(struct batch_tree *tree, int n);
+
+/**
+ * @brief Fills one node of the binary tree (and its subtree) from a
+ * classifier.
+ *
+ * A shared node which was already filled is copied, thus it points to the
+ * same children.
+ *
+ * @param descr The description of the problem
+ * @param tree The binary tree
+ * @param map Shared nodes already filled
+ * @param idx Index of node to fill
+ * @param cls The classifier (NULL for unknown class)
+ * @return Height of the subtree (steps needed to reach any leaf)
+ */
+static int batch_fill(const struct description *descr,
+		struct batch_tree *tree, struct node_map *map, int idx,
+		const struct classifier *cls);
+
+/**
+ * @brief Fills one node of the binary tree with the binary tests selecting
+ * the branches lo..hi of a numeric classifier.
+ *
+ * If the thresholds are sorted the tests are balanced, otherwise they are
+ * done in the order of the thresholds (as in a linear scan).
+ *
+ * @param descr The description of the problem
+ * @param tree The binary tree
+ * @param map Shared nodes already filled
+ * @param idx Index of node to fill
+ * @param cls The numeric classifier
+ * @param lo First branch
+ * @param hi Last branch
+ * @param sorted 1 if the thresholds are sorted
+ * @return Height of the subtree
+ */
+static int batch_fill_numeric(const struct description *descr,
+		struct batch_tree *tree, struct node_map *map, int idx,
+		const struct classifier *cls, int lo, int hi, int sorted);
+
+/**
+ * @brief Advances at most BATCH_LANES examples through the binary tree.
+ *
+ * @param tree The binary tree
+ * @param rows Attribute values of the examples
+ * @param count Count of examples
+ * @param classes Output: id of class for each example
+ */
+static void batch_walk(const struct batch_tree *tree, const int *rows,
+		int count, int *classes);
+
+#ifdef BATCH_AVX2
+/**
+ * @brief Advances exactly BATCH_LANES examples through the binary tree,
+ * using AVX2 gathers and compare/select operations.
+ *
+ * @param tree The binary tree
+ * @param rows Attribute values of the examples
+ * @param classes Output: id of class for each example
+ */
+static void batch_walk_avx2(const struct batch_tree *tree, const int *rows,
+		int *classes);
+#endif
+
+/**
+ * @brief Checks that the nodes of a subtree are oblivious, recording the
+ * tests of its levels.
+ *
+ * @param descr The description of the problem
+ * @param tree The table (levels found so far)
+ * @param cls The node
+ * @param depth Depth of the node
+ * @return 0 if oblivious, -1 otherwise
+ */
+static int oblivious_levels(const struct description *descr,
+		struct oblivious_tree *tree, const struct classifier *cls,
+		int depth);
+
+/**
+ * @brief Fills the leaves of the table reached through a node.
+ *
+ * @param tree The table
+ * @param cls The node
+ * @param depth Depth of the node
+ * @param base Index of the first leaf reached through the node
+ * @param span Count of leaves reached through the node
+ */
+static void oblivious_fill(struct oblivious_tree *tree,
+		const struct classifier *cls, int depth, int base, int span);
+
+void map_init(struct node_map *map)
+{
+	map->size = 16;
+	map->count = 0;
+	map->keys = calloc(map->size, sizeof(map->keys[0]));
+	map->index = calloc(map->size, sizeof(map->index[0]));
+	map->height = calloc(map->size, sizeof(map->height[0]));
+}
+
+int map_find(const struct node_map *map, const struct classifier *cls)
+{
+	unsigned slot;
+
+	slot = ((uintptr_t)cls >> 4) * 2654435761u & (map->size - 1);
+	for (; map->keys[slot] != NULL; slot = (slot + 1) & (map->size - 1))
+		if (map->keys[slot] == cls)
+			return slot;
+	return -1;
+}
+
+void map_add(struct node_map *map, const struct classifier *cls,
+		int index, int height)
+{
+	struct node_map old = *map;
+	unsigned slot, i;
+
+	if (2 * (map->count + 1) > map->size) {
+		map->size *= 2;
+		map->count = 0;
+		map->keys = calloc(map->size, sizeof(map->keys[0]));
+		map->index = calloc(map->size, sizeof(map->index[0]));
+		map->height = calloc(map->size, sizeof(map->height[0]));
+		for (i = 0; i < old.size; i++)
+			if (old.keys[i] != NULL)
+				map_add(map, old.keys[i], old.index[i],
+						old.height[i]);
+		map_free(&old);
+	}
+
+	slot = ((uintptr_t)cls >> 4) * 2654435761u & (map->size - 1);
+	while (map->keys[slot] != NULL)
+		slot = (slot + 1) & (map->size - 1);
+	map->keys[slot] = cls;
+	map->index[slot] = index;
+	map->height[slot] = height;
+	map->count++;
+}
+
+void map_free(struct node_map *map)
+{
+	free_and_set_NULL(map->keys);
+	free_and_set_NULL(map->index);
+	free_and_set_NULL(map->height);
+}
+
+int count_nodes(const struct description *descr,
+		const struct classifier *cls, struct node_map *map,
+		int *values)
+{
+	int i, count;
+
+	if (cls == NULL || cls->C == 0)
+		return 1;
+	if (cls->shared) {
+		if (map_find(map, cls) >= 0)
+			return 1;
+		map_add(map, cls, 0, 0);
+	}
+
+	count = 1;
+	if (descr->attribs[cls->id]->type == NUMERIC) {
+		*values += cls->C - 1;
+		for (i = 0; i < cls->C; i++)
+			count += count_nodes(descr, cls->cls[i], map, values);
+		return count;
+	}
+
+	/* one child for each value, a default branch fills several */
+	for (i = 0; i < descr->attribs[cls->id]->C; i++)
+		count += count_nodes(descr, discrete_branch(cls, i), map,
+				values);
+	return count;
+}
+
+const struct classifier *discrete_branch(const struct classifier *cls, int v)
+{
+	int i;
+
+	for (i = 0; i < cls->C; i++)
+		if (cls->values[i] == v || cls->values[i] == CLS_ANY)
+			return cls->cls[i];
+	return NULL;
+}
+
+int sorted_thresholds(const struct classifier *cls)
+{
+	int i;
+
+	for (i = 1; i < cls->C - 1; i++)
+		if (cls->values[i - 1] > cls->values[i])
+			return 0;
+	return 1;
+}
+
+struct flat_tree *flat_alloc(const struct description *descr,
+		const struct classifier *cls)
+{
+	struct flat_tree *tree;
+	struct node_map map;
+
+	map_init(&map);
+	tree = calloc(1, sizeof(*tree));
+	tree->count = count_nodes(descr, cls, &map, &tree->vcount);
+	map_free(&map);
+	tree->nodes = calloc(tree->count, sizeof(tree->nodes[0]));
+	tree->values = calloc(tree->vcount, sizeof(tree->values[0]));
+	return tree;
+}
+
+int flat_fill(const struct description *descr,
+		struct flat_tree *tree, const struct classifier **slots,
+		struct node_map *map, int idx, int *tail, int *v)
+{
+	const struct classifier *cls = slots[idx];
+	struct flat_node *node;
+	int i;
+
+	node = &tree->nodes[idx];
+	node->kind = FLAT_LEAF;
+	node->id = cls != NULL ? cls->id : -1;
+	node->tag = cls != NULL ? cls->tag : -1;
+	if (cls == NULL || cls->C == 0)
+		return 0;
+	if (cls->shared) {
+		i = map_find(map, cls);
+		if (i >= 0) {
+			*node = tree->nodes[map->index[i]];
+			return 1;
+		}
+		map_add(map, cls, idx, 0);
+	}
+
+	node->first = *tail;
+	node->values = *v;
+	if (descr->attribs[cls->id]->type == NUMERIC) {
+		node->C = cls->C;
+		node->kind = FLAT_NUMERIC;
+		if (cls->C - 1 > FLAT_SCAN_MAX && sorted_thresholds(cls))
+			node->kind = FLAT_NUMERIC_BSEARCH;
+		for (i = 0; i < cls->C; i++) {
+			if (i < cls->C - 1)
+				tree->values[(*v)++] = cls->values[i];
+			slots[(*tail)++] = cls->cls[i];
+		}
+		return 0;
+	}
+
+	node->C = descr->attribs[cls->id]->C;
+	node->kind = FLAT_DISCRETE;
+	for (i = 0; i < node->C; i++)
+		slots[(*tail)++] = discrete_branch(cls, i);
+	return 0;
+}
+
+struct flat_tree *flatten_classifier(const struct description *descr,
+		const struct classifier *cls)
+{
+	const struct classifier **queue;
+	struct flat_tree *tree;
+	struct node_map map;
+	int head, tail, v;
+
+	tree = flat_alloc(descr, cls);
+	map_init(&map);
+
+	/* NULL entries in the queue are unknown class leaves */
+	queue = calloc(tree->count, sizeof(queue[0]));
+	queue[0] = cls;
+	for (head = 0, tail = 1, v = 0; head < tail; head++)
+		flat_fill(descr, tree, queue, &map, head, &tail, &v);
+
+	free(queue);
+	map_free(&map);
+	return tree;
+}
+
+long long profile_visits(const struct flat_profile *profile,
+		const struct classifier *cls)
+{
+	if (cls == NULL || cls->tag < 0 || cls->tag >= profile->count)
+		return 0;
+	return profile->visits[cls->tag];
+}
+
+struct flat_tree *flatten_profiled(const struct description *descr,
+		const struct classifier *cls,
+		const struct flat_profile *profile)
+{
+	const struct classifier **slots;
+	int *stack, *cold, sp, base, chead, ctail, tail, v, idx, i, j, k;
+	struct flat_tree *tree;
+	struct flat_node *node;
+	struct node_map map;
+	long long total, best, hits;
+
+	tree = flat_alloc(descr, cls);
+	map_init(&map);
+	slots = calloc(tree->count, sizeof(slots[0]));
+	stack = calloc(tree->count, sizeof(stack[0]));
+	cold = calloc(tree->count, sizeof(cold[0]));
+
+	slots[0] = cls;
+	stack[0] = 0;
+	sp = 1;
+	chead = 0;
+	ctail = 0;
+	tail = 1;
+	v = 0;
+	while (sp || chead < ctail) {
+		idx = sp ? stack[--sp] : cold[chead++];
+		/* copies of shared nodes are already laid out */
+		SKIPIF(flat_fill(descr, tree, slots, &map, idx, &tail, &v));
+		node = &tree->nodes[idx];
+		SKIPIF(node->kind == FLAT_LEAF);
+
+		/* visited children go on the stack, the hottest one on top */
+		for (base = sp, j = 0; j < node->C; j++) {
+			k = node->first + j;
+			hits = profile_visits(profile, slots[k]);
+			if (hits == 0) {
+				cold[ctail++] = k;
+				continue;
+			}
+			for (i = sp++; i > base && hits <
+				profile_visits(profile, slots[stack[i - 1]]); i--)
+				stack[i] = stack[i - 1];
+			stack[i] = k;
+		}
+		SKIPIF(node->kind == FLAT_DISCRETE ||
+				!sorted_thresholds(slots[idx]));
+
+		total = profile_visits(profile, slots[idx]);
+		for (j = 0, best = 0; j < node->C; j++) {
+			hits = profile_visits(profile, slots[node->first + j]);
+			SKIPIF(hits <= best);
+			best = hits;
+			node->hot = j;
+		}
+		if (2 * best > total)
+			node->kind = FLAT_NUMERIC_HOT;
+	}
+
+	free(slots);
+	free(stack);
+	free(cold);
+	map_free(&map);
+	return tree;
+}
+
+int bsearch_branch(const int *values, int n, int v)
+{
+	const int *base;
+	int half;
+
+	base = values;
+	while (n > 1) {
+		half = n / 2;
+		base = base[half] <= v ? base + half : base;
+		n -= half;
+	}
+	return base - values + (*base <= v);
+}
+
+int flat_classify(const struct flat_tree *tree, const int *attr_ids)
+{
+	const struct flat_node *node;
+	const int *values;
+	int i, v;
+
+	node = tree->nodes;
+	while (node->kind != FLAT_LEAF) {
+		v = attr_ids[node->id];
+		values = tree->values + node->values;
+		switch (node->kind) {
+		case FLAT_NUMERIC:
+			for (i = 0; i < node->C - 1; i++)
+				if (v < values[i])
+					break;
+			break;
+		case FLAT_NUMERIC_HOT:
+			i = node->hot;
+			if ((i == 0 || values[i - 1] <= v) &&
+					(i == node->C - 1 || v < values[i]))
+				break;
+			/* fall through */
+		case FLAT_NUMERIC_BSEARCH:
+			i = bsearch_branch(values, node->C - 1, v);
+			break;
+		default:
+			if ((unsigned)v >= (unsigned)node->C)
+				return -1;
+			i = v;
+			break;
+		}
+		node = tree->nodes + node->first + i;
+	}
+
+	return node->id;
+}
+
+int flat_classify_profile(const struct flat_tree *tree, const int *attr_ids,
+		long long *visits)
+{
+	const struct flat_node *node;
+	const int *values;
+	int i, v;
+
+	node = tree->nodes;
+	visits[0]++;
+	while (node->kind != FLAT_LEAF) {
+		v = attr_ids[node->id];
+		values = tree->values + node->values;
+		switch (node->kind) {
+		case FLAT_NUMERIC:
+			for (i = 0; i < node->C - 1; i++)
+				if (v < values[i])
+					break;
+			break;
+		case FLAT_NUMERIC_HOT:
+		case FLAT_NUMERIC_BSEARCH:
+			i = bsearch_branch(values, node->C - 1, v);
+			break;
+		default:
+			if ((unsigned)v >= (unsigned)node->C)
+				return -1;
+			i = v;
+			break;
+		}
+		visits[node->first + i]++;
+		node = tree->nodes + node->first + i;
+	}
+
+	return node->id;
+}
+
+struct flat_profile *read_profile(FILE *file)
+{
+	struct flat_profile *profile;
+	long long visits;
+	int i, n, tag;
+
+	CHECK(fscanf(file, "%d", &n) == 1 && n >= 0, fail);
+	profile = calloc(1, sizeof(*profile));
+	for (i = 0; i < n; i++) {
+		CHECK(fscanf(file, "%d%lld", &tag, &visits) == 2, noprofile);
+		CHECK(tag >= 0, noprofile);
+		if (tag >= profile->count) {
+			profile->visits = realloc(profile->visits,
+					(tag + 1) * sizeof(visits));
+			memset(profile->visits + profile->count, 0,
+					(tag + 1 - profile->count) *
+					sizeof(visits));
+			profile->count = tag + 1;
+		}
+		profile->visits[tag] += visits;
+	}
+	return profile;
+noprofile:
+	free_profile(profile);
+fail:
+	return NULL;
+}
+
+void write_profile(const struct flat_tree *tree, const long long *visits,
+		FILE *file)
+{
+	int i, n;
+
+	for (i = 0, n = 0; i < tree->count; i++)
+		INCRIF(tree->nodes[i].tag >= 0, n);
+	fprintf(file, "%d\n", n);
+	for (i = 0; i < tree->count; i++)
+		if (tree->nodes[i].tag >= 0)
+			fprintf(file, "%d %lld\n", tree->nodes[i].tag,
+					visits[i]);
+}
+
+int batch_reserve(struct batch_tree *tree, int n)
+{
+	int first;
+
+	if (tree->count + n > tree->size) {
+		tree->size = 2 * (tree->count + n);
+		tree->kind = realloc(tree->kind, tree->size * sizeof(int));
+		tree->attr = realloc(tree->attr, tree->size * sizeof(int));
+		tree->thr = realloc(tree->thr, tree->size * sizeof(int));
+		tree->card = realloc(tree->card, tree->size * sizeof(int));
+		tree->base = realloc(tree->base, tree->size * sizeof(int));
+		tree->cls = realloc(tree->cls, tree->size * sizeof(int));
+	}
+
+	first = tree->count;
+	tree->count += n;
+	for (; n; n--) {
+		tree->kind[tree->count - n] = BATCH_LEAF;
+		tree->attr[tree->count - n] = 0;
+		tree->thr[tree->count - n] = 0;
+		tree->card[tree->count - n] = 0;
+		tree->base[tree->count - n] = tree->count - n;
+		tree->cls[tree->count - n] = -1;
+	}
+	return first;
+}
+
+int batch_fill(const struct description *descr,
+		struct batch_tree *tree, struct node_map *map, int idx,
+		const struct classifier *cls)
+{
+	int i, j, C, first, height, h;
+
+	if (cls == NULL)
+		return 0;
+	if (cls->C == 0) {
+		tree->cls[idx] = cls->id;
+		return 0;
+	}
+	if (cls->shared && (i = map_find(map, cls)) >= 0) {
+		j = map->index[i];
+		tree->kind[idx] = tree->kind[j];
+		tree->attr[idx] = tree->attr[j];
+		tree->thr[idx] = tree->thr[j];
+		tree->card[idx] = tree->card[j];
+		tree->base[idx] = tree->base[j];
+		tree->cls[idx] = tree->cls[j];
+		return map->height[i];
+	}
+
+	if (descr->attribs[cls->id]->type == NUMERIC) {
+		height = batch_fill_numeric(descr, tree, map, idx, cls, 0,
+				cls->C - 1, sorted_thresholds(cls));
+		goto done;
+	}
+
+	/* first matching branch wins, last child is the unknown class */
+	C = descr->attribs[cls->id]->C;
+	first = batch_reserve(tree, C + 1);
+	tree->kind[idx] = BATCH_DISCRETE;
+	tree->attr[idx] = cls->id;
+	tree->card[idx] = C;
+	tree->base[idx] = first;
+	height = 1;
+	for (i = 0; i < C; i++) {
+		h = 1 + batch_fill(descr, tree, map, first + i,
+				discrete_branch(cls, i));
+		if (height < h)
+			height = h;
+	}
+
+done:
+	if (cls->shared)
+		map_add(map, cls, idx, height);
+	return height;
+}
+
+int batch_fill_numeric(const struct description *descr,
+		struct batch_tree *tree, struct node_map *map, int idx,
+		const struct classifier *cls, int lo, int hi, int sorted)
+{
+	int mid, first, height, h;
+
+	if (lo == hi)
+		return batch_fill(descr, tree, map, idx, cls->cls[lo]);
+
+	mid = sorted ? (lo + hi) / 2 : lo;
+	first = batch_reserve(tree, 2);
+	tree->kind[idx] = BATCH_NUMERIC;
+	tree->attr[idx] = cls->id;
+	tree->thr[idx] = cls->values[mid];
+	tree->base[idx] = first;
+	height = batch_fill_numeric(descr, tree, map, first, cls, lo, mid,
+			sorted);
+	h = batch_fill_numeric(descr, tree, map, first + 1, cls, mid + 1, hi,
+			sorted);
+	return 1 + (height > h ? height : h);
+}
+
+struct batch_tree *batch_compile(const struct description *descr,
+		const struct classifier *cls)
+{
+	struct batch_tree *tree;
+	struct node_map map;
+
+	map_init(&map);
+	tree = calloc(1, sizeof(*tree));
+	tree->M = descr->M;
+	batch_reserve(tree, 1);
+	tree->depth = batch_fill(descr, tree, &map, 0, cls);
+	map_free(&map);
+	return tree;
+}
+
+void batch_walk(const struct batch_tree *tree, const int *rows,
+		int count, int *classes)
+{
+	int idx[BATCH_LANES], i, n, v, sel, step;
+
+	for (i = 0; i < count; i++)
+		idx[i] = 0;
+
+	for (step = 0; step < tree->depth; step++)
+		for (i = 0; i < count; i++) {
+			n = idx[i];
+			v = rows[i * tree->M + tree->attr[n]];
+			if (tree->kind[n] == BATCH_DISCRETE)
+				sel = (unsigned)v < (unsigned)tree->card[n] ?
+					v : tree->card[n];
+			else
+				sel = tree->kind[n] == BATCH_NUMERIC &&
+					v >= tree->thr[n];
+			idx[i] = tree->base[n] + sel;
+		}
+
+	for (i = 0; i < count; i++)
+		classes[i] = tree->cls[idx[i]];
+}
+
+#ifdef BATCH_AVX2
+__attribute__((target("avx2")))
+void batch_walk_avx2(const struct batch_tree *tree, const int *rows,
+		int *classes)
+{
+	__m256i one, num, dsc, row[2], idx[2], a, v, k, t, c, b, sel;
+	int step, i;
+
+	one = _mm256_set1_epi32(1);
+	num = _mm256_set1_epi32(BATCH_NUMERIC);
+	dsc = _mm256_set1_epi32(BATCH_DISCRETE);
+	row[0] = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+			_mm256_set1_epi32(tree->M));
+	row[1] = _mm256_add_epi32(row[0], _mm256_set1_epi32(8 * tree->M));
+	idx[0] = _mm256_setzero_si256();
+	idx[1] = _mm256_setzero_si256();
+
+	for (step = 0; step < tree->depth; step++)
+		for (i = 0; i < 2; i++) {
+			a = _mm256_i32gather_epi32(tree->attr, idx[i], 4);
+			v = _mm256_i32gather_epi32(rows,
+					_mm256_add_epi32(row[i], a), 4);
+			k = _mm256_i32gather_epi32(tree->kind, idx[i], 4);
+			t = _mm256_i32gather_epi32(tree->thr, idx[i], 4);
+			c = _mm256_i32gather_epi32(tree->card, idx[i], 4);
+			b = _mm256_i32gather_epi32(tree->base, idx[i], 4);
+			/* numeric: v >= t, that is !(t > v) */
+			sel = _mm256_andnot_si256(_mm256_cmpgt_epi32(t, v), one);
+			sel = _mm256_and_si256(sel, _mm256_cmpeq_epi32(k, num));
+			/* discrete: v if in 0..C-1, C otherwise */
+			sel = _mm256_blendv_epi8(sel, _mm256_min_epu32(v, c),
+					_mm256_cmpeq_epi32(k, dsc));
+			idx[i] = _mm256_add_epi32(b, sel);
+		}
+
+	for (i = 0; i < 2; i++)
+		_mm256_storeu_si256((__m256i *)(classes + 8 * i),
+				_mm256_i32gather_epi32(tree->cls, idx[i], 4));
+}
+#endif
+
+void batch_classify(const struct batch_tree *tree, const int *rows,
+		int count, int *classes)
+{
+	int i, n;
+#ifdef BATCH_AVX2
+	int avx2 = __builtin_cpu_supports("avx2");
+#endif
+
+	for (i = 0; i < count; i += BATCH_LANES) {
+		n = count - i < BATCH_LANES ? count - i : BATCH_LANES;
+#ifdef BATCH_AVX2
+		if (avx2 && n == BATCH_LANES) {
+			batch_walk_avx2(tree, rows + i * tree->M, classes + i);
+			continue;
+		}
+#endif
+		batch_walk(tree, rows + i * tree->M, n, classes + i);
+	}
+}
+
+struct oblivious_tree *oblivious_compile(const struct description *descr,
+		const struct classifier *cls)
+{
+	struct oblivious_tree *tree;
+	int d;
+
+	tree = calloc(1, sizeof(*tree));
+	tree->M = descr->M;
+	tree->first = calloc(1, sizeof(tree->first[0]));
+	CHECK(oblivious_levels(descr, tree, cls, 0) == 0, fail);
+
+	for (d = 0, tree->size = 1; d < tree->depth; d++) {
+		CHECK(tree->size <= OBLIVIOUS_MAX / tree->radix[d], fail);
+		tree->size *= tree->radix[d];
+	}
+	tree->classes = calloc(tree->size, sizeof(tree->classes[0]));
+	oblivious_fill(tree, cls, 0, 0, tree->size);
+	return tree;
+fail:
+	free_oblivious_tree(tree);
+	return NULL;
+}
+
+int oblivious_levels(const struct description *descr,
+		struct oblivious_tree *tree, const struct classifier *cls,
+		int depth)
+{
+	int i, d, n, numeric;
+
+	if (cls->C == 0)
+		return 0;
+	CHECK(cls->C > 0, fail);
+	numeric = descr->attribs[cls->id]->type == NUMERIC;
+
+	if (depth == tree->depth) {
+		d = tree->depth++;
+		tree->attr = realloc(tree->attr, tree->depth *
+				sizeof(tree->attr[0]));
+		tree->radix = realloc(tree->radix, tree->depth *
+				sizeof(tree->radix[0]));
+		tree->numeric = realloc(tree->numeric, tree->depth *
+				sizeof(tree->numeric[0]));
+		tree->first = realloc(tree->first, (tree->depth + 1) *
+				sizeof(tree->first[0]));
+		tree->attr[d] = cls->id;
+		tree->radix[d] = cls->C;
+		tree->numeric[d] = numeric;
+		n = numeric ? cls->C - 1 : 0;
+		tree->first[d + 1] = tree->first[d] + n;
+		tree->limits = realloc(tree->limits, (tree->first[d + 1] + 1) *
+				sizeof(tree->limits[0]));
+		for (i = 0; i < n; i++) {
+			/* the branch is the count of thresholds <= value */
+			CHECK(i == 0 || cls->values[i - 1] < cls->values[i],
+					fail);
+			tree->limits[tree->first[d] + i] = cls->values[i];
+		}
+	}
+
+	CHECK(tree->attr[depth] == cls->id, fail);
+	CHECK(tree->radix[depth] == cls->C, fail);
+	for (i = 0; i < cls->C; i++)
+		if (numeric)
+			CHECK(i == cls->C - 1 || cls->values[i] ==
+				tree->limits[tree->first[depth] + i], fail);
+		else
+			/* every value has its branch, in order */
+			CHECK(cls->values[i] == i, fail);
+	CHECK(numeric || cls->C == descr->attribs[cls->id]->C, fail);
+
+	for (i = 0; i < cls->C; i++)
+		CHECK(oblivious_levels(descr, tree, cls->cls[i],
+					depth + 1) == 0, fail);
+	return 0;
+fail:
+	return -1;
+}
+
+void oblivious_fill(struct oblivious_tree *tree,
+		const struct classifier *cls, int depth, int base, int span)
+{
+	int i;
+
+	if (cls->C == 0) {
+		for (i = 0; i < span; i++)
+			tree->classes[base + i] = cls->id;
+		return;
+	}
+
+	span /= tree->radix[depth];
+	for (i = 0; i < cls->C; i++)
+		oblivious_fill(tree, cls->cls[i], depth + 1, base + i * span,
+				span);
+}
+
+int oblivious_classify(const struct oblivious_tree *tree,
+		const int *attr_ids)
+{
+	int d, i, v, b, idx, bad;
+
+	for (d = 0, idx = 0, bad = 0; d < tree->depth; d++) {
+		v = attr_ids[tree->attr[d]];
+		if (tree->numeric[d])
+			for (i = tree->first[d], b = 0; i < tree->first[d + 1];
+					i++)
+				b += v >= tree->limits[i];
+		else {
+			bad |= (unsigned)v >= (unsigned)tree->radix[d];
+			b = (unsigned)v < (unsigned)tree->radix[d] ? v : 0;
+		}
+		idx = idx * tree->radix[d] + b;
+	}
+	return bad ? -1 : tree->classes[idx];
+}
+
+void oblivious_classify_batch(const struct oblivious_tree *tree,
+		const int *rows, int count, int *classes)
+{
+	int idx[BATCH_LANES], bad[BATCH_LANES];
+	int d, i, l, n, v, b, M;
+	const int *row;
+
+	M = tree->M;
+	for (n = 0; n < count; n += BATCH_LANES) {
+		row = rows + n * M;
+		l = count - n < BATCH_LANES ? count - n : BATCH_LANES;
+		memset(idx, 0, sizeof(idx));
+		memset(bad, 0, sizeof(bad));
+		for (d = 0; d < tree->depth; d++) {
+			if (tree->numeric[d])
+				for (i = 0; i < l; i++) {
+					v = row[i * M + tree->attr[d]];
+					for (b = tree->first[d], idx[i] *=
+							tree->radix[d];
+						b < tree->first[d + 1]; b++)
+						idx[i] += v >= tree->limits[b];
+				}
+			else
+				for (i = 0; i < l; i++) {
+					v = row[i * M + tree->attr[d]];
+					b = (unsigned)v < (unsigned)tree->radix[d];
+					bad[i] |= !b;
+					idx[i] = idx[i] * tree->radix[d] +
+						(b ? v : 0);
+				}
+		}
+		for (i = 0; i < l; i++)
+			classes[n + i] = bad[i] ? -1 : tree->classes[idx[i]];
+	}
+}
+
+void free_oblivious_tree(struct oblivious_tree *ptr)
+{
+	if (ptr == NULL)
+		return;
+
+	free_and_set_NULL(ptr->attr);
+	free_and_set_NULL(ptr->radix);
+	free_and_set_NULL(ptr->numeric);
+	free_and_set_NULL(ptr->first);
+	free_and_set_NULL(ptr->limits);
+	free_and_set_NULL(ptr->classes);
+	free_and_set_NULL(ptr);
+}
+
+void free_batch_tree(struct batch_tree *ptr)
+{
+	if (ptr == NULL)
+		return;
+
+	free_and_set_NULL(ptr->kind);
+	free_and_set_NULL(ptr->attr);
+	free_and_set_NULL(ptr->thr);
+	free_and_set_NULL(ptr->card);
+	free_and_set_NULL(ptr->base);
+	free_and_set_NULL(ptr->cls);
+	free_and_set_NULL(ptr);
+}
+
+void free_profile(struct flat_profile *ptr)
+{
+	if (ptr == NULL)
+		return;
+
+	free_and_set_NULL(ptr->visits);
+	free_and_set_NULL(ptr);
+}
+
+void free_flat_tree(struct flat_tree *ptr)
+{
+	if (ptr == NULL)
+		return;
+
+	free_and_set_NULL(ptr->nodes);
+	free_and_set_NULL(ptr->values);
+	free_and_set_NULL(ptr);
+}
@@ -0,0 +1,340 @@
+/*!
+ * @file id3flat.h
+ * @brief Compiled (flattened) form of an id3 classifier.
+ * @author Mihai Maruseac (mihai@rosedu.org)
+ *
+ * @section DESCRIPTION
+ * IAUT1: ID3: Compiled (flattened) form of an id3 classifier.
+ *
+ * Contains the functions used to transform an id3 tree into a contiguous
+ * vector of nodes, faster to walk when classifying many examples.
+ *
+ * @section QUOTE
+ * Premature optimization is the root of all evil. (Donald Knuth)
+ *
+ * @bug No known bugs.
+ */
+
+#ifndef _ID3FLAT_H
+#define _ID3FLAT_H
+
+#define FLAT_SCAN_MAX 4 /**< @brief Max thresholds scanned linearly */
+#define BATCH_LANES 16 /**< @brief Examples advanced together in batch mode */
+#define OBLIVIOUS_MAX (1 << 20) /**< @brief Max leaves of an oblivious table */
+
+/**
+ * @brief Enumeration of possible kinds of a flattened node.
+ */
+enum flat_kind {
+	/** Leaf (class) */
+	FLAT_LEAF,
+	/** Test on a numeric attribute, thresholds scanned linearly */
+	FLAT_NUMERIC,
+	/** Test on a numeric attribute, thresholds searched binary */
+	FLAT_NUMERIC_BSEARCH,
+	/** Test on a numeric attribute, hot branch tested first, then the
+	 * thresholds are searched binary */
+	FLAT_NUMERIC_HOT,
+	/** Test on a discrete attribute, child indexed by value */
+	FLAT_DISCRETE
+};
+
+/**
+ * @brief Structure representing a node of the flattened tree.
+ *
+ * The children of a node are consecutive in the nodes vector, starting at
+ * index first. For numeric nodes, the thresholds used to select the branch
+ * are consecutive in the values vector of the tree, starting at index
+ * values. Discrete nodes have one child for each value of the attribute
+ * (values which are not in the classifier lead to an unknown class leaf),
+ * thus the branch is selected directly by the value.
+ */
+struct flat_node {
+	/** Kind of node (type of attribute folded in) */
+	enum flat_kind kind;
+	/** Id of attribute or class (-1 for unknown class) */
+	int id;
+	/** Count of branches or 0 if class */
+	int C;
+	/** Index of first child */
+	int first;
+	/** Index of first value */
+	int values;
+	/** Most visited branch (FLAT_NUMERIC_HOT nodes) */
+	int hot;
+	/** Tag of the classifier node (-1 for unknown class leaves) */
+	int tag;
+};
+
+/**
+ * @brief Structure representing the flattened id3 tree.
+ *
+ * The nodes are laid out in breadth-first order, the root being the first
+ * one, unless the tree is built using a profile (see flatten_profiled).
+ */
+struct flat_tree {
+	/** Count of nodes */
+	int count;
+	/** Nodes */
+	struct flat_node *nodes;
+	/** Count of values */
+	int vcount;
+	/** Thresholds of all numeric nodes */
+	int *values;
+};
+
+/**
+ * @brief Structure representing the visit counts of the nodes of a
+ * classifier, recorded while classifying a representative set of examples.
+ */
+struct flat_profile {
+	/** Count of tags (greatest tag + 1) */
+	int count;
+	/** Count of visits of the node with each tag */
+	long long *visits;
+};
+
+/**
+ * @brief Enumeration of possible kinds of a batch tree node.
+ */
+enum batch_kind {
+	/** Leaf (class), the next node is the node itself */
+	BATCH_LEAF,
+	/** Binary test v < threshold on a numeric attribute */
+	BATCH_NUMERIC,
+	/** Test on a discrete attribute, child indexed by value */
+	BATCH_DISCRETE
+};
+
+/**
+ * @brief Structure representing the binary form of the id3 tree, used to
+ * classify many examples at once.
+ *
+ * Each numeric node with several thresholds is replaced by a tree of binary
+ * tests, such that every node computes the index of the next node as base +
+ * selector: the selector is 0 for a leaf, (v >= threshold) for a numeric
+ * node and v for a discrete node (values outside the attribute lead to an
+ * unknown class leaf at base + C). Thus, a group of examples can be moved
+ * one level down the tree with gathers and compare/select operations only.
+ *
+ * The fields of the nodes are kept in separate vectors.
+ */
+struct batch_tree {
+	/** Count of nodes */
+	int count;
+	/** Allocated nodes */
+	int size;
+	/** Depth of the tree (steps needed to reach any leaf) */
+	int depth;
+	/** Count of attributes of one example */
+	int M;
+	/** Kind of each node (as an enum batch_kind) */
+	int *kind;
+	/** Id of attribute tested in each node (0 for leaves) */
+	int *attr;
+	/** Threshold of numeric nodes */
+	int *thr;
+	/** Count of values of discrete nodes */
+	int *card;
+	/** Index of first child (the node itself for leaves) */
+	int *base;
+	/** Id of class of leaves (-1 for unknown class) */
+	int *cls;
+};
+
+/**
+ * @brief Structure representing an oblivious classifier as a table of
+ * leaves.
+ *
+ * In an oblivious classifier, all the nodes at the same depth test the same
+ * attribute with the same values (a node may be a leaf before the last
+ * level). Each level turns the value of its attribute into a branch without
+ * jumps: the count of thresholds not greater than the value for a numeric
+ * attribute, the value itself for a discrete one. The branches of all
+ * levels, read as a mixed radix number, give the index of the class in the
+ * table.
+ */
+struct oblivious_tree {
+	/** Count of levels */
+	int depth;
+	/** Count of attributes of one example */
+	int M;
+	/** Attribute tested at each level */
+	int *attr;
+	/** Count of branches of each level */
+	int *radix;
+	/** 1 if the attribute of a level is numeric */
+	int *numeric;
+	/** Index of the first threshold of each level (depth + 1 values) */
+	int *first;
+	/** Thresholds of numeric levels, ascending for each level */
+	int *limits;
+	/** Count of leaves of the table */
+	int size;
+	/** Class of each leaf of the table (-1 for unknown class) */
+	int *classes;
+};
+
+/**
+ * @brief Builds the flattened form of a classifier.
+ *
+ * @param descr The description of the problem
+ * @param cls The classifier
+ * @return The flattened tree
+ */
+struct flat_tree *flatten_classifier(const struct description *descr,
+		const struct classifier *cls);
+
+/**
+ * @brief Builds the flattened form of a classifier, laid out using a
+ * profile.
+ *
+ * The nodes are placed in depth-first order, the most visited child first,
+ * such that the hot paths are packed at the start of the nodes vector. The
+ * subtrees never visited are placed at the end. Numeric nodes with a branch
+ * taking most of the visits test it before the other ones.
+ *
+ * @param descr The description of the problem
+ * @param cls The classifier
+ * @param profile The profile
+ * @return The flattened tree
+ */
+struct flat_tree *flatten_profiled(const struct description *descr,
+		const struct classifier *cls,
+		const struct flat_profile *profile);
+
+/**
+ * @brief Classifies one example using the flattened tree.
+ *
+ * @param tree The flattened tree
+ * @param attr_ids Attribute values of the example
+ * @return Id of class or -1 if the class is unknown.
+ */
+int flat_classify(const struct flat_tree *tree, const int *attr_ids);
+
+/**
+ * @brief Classifies one example using the flattened tree, counting the
+ * visits of the nodes.
+ *
+ * @param tree The flattened tree
+ * @param attr_ids Attribute values of the example
+ * @param visits Visit count of each node of the tree (incremented)
+ * @return Id of class or -1 if the class is unknown.
+ */
+int flat_classify_profile(const struct flat_tree *tree, const int *attr_ids,
+		long long *visits);
+
+/**
+ * @brief Reads a profile.
+ *
+ * @param file File containing the profile
+ * @return The profile or NULL on error
+ */
+struct flat_profile *read_profile(FILE *file);
+
+/**
+ * @brief Writes the profile recorded using a flattened tree.
+ *
+ * The file contains the count of nodes, then one line for each node: the
+ * tag and the count of visits.
+ *
+ * @param tree The flattened tree
+ * @param visits Visit count of each node of the tree
+ * @param file File to write to.
+ */
+void write_profile(const struct flat_tree *tree, const long long *visits,
+		FILE *file);
+
+/**
+ * @brief Builds the binary form of a classifier, used in batch mode.
+ *
+ * @param descr The description of the problem
+ * @param cls The classifier
+ * @return The binary tree
+ */
+struct batch_tree *batch_compile(const struct description *descr,
+		const struct classifier *cls);
+
+/**
+ * @brief Classifies a block of examples using the binary tree.
+ *
+ * The examples are advanced through the tree BATCH_LANES at a time, in
+ * lockstep. The results are identical to the ones of flat_classify.
+ *
+ * @param tree The binary tree
+ * @param rows Attribute values of the examples, one example after another
+ * @param count Count of examples
+ * @param classes Output: id of class (or -1) for each example
+ */
+void batch_classify(const struct batch_tree *tree, const int *rows,
+		int count, int *classes);
+
+/**
+ * @brief Builds the table of leaves of an oblivious classifier.
+ *
+ * @param descr The description of the problem
+ * @param cls The classifier
+ * @return The table or NULL if the classifier is not oblivious (or its table
+ * would have more than OBLIVIOUS_MAX leaves)
+ */
+struct oblivious_tree *oblivious_compile(const struct description *descr,
+		const struct classifier *cls);
+
+/**
+ * @brief Classifies one example using the table of an oblivious classifier.
+ *
+ * The results are identical to the ones of flat_classify, except that a
+ * value outside a discrete attribute always gives the unknown class.
+ *
+ * @param tree The table
+ * @param attr_ids Attribute values of the example
+ * @return Id of class or -1 if the class is unknown.
+ */
+int oblivious_classify(const struct oblivious_tree *tree,
+		const int *attr_ids);
+
+/**
+ * @brief Classifies a block of examples using the table of an oblivious
+ * classifier.
+ *
+ * The index of BATCH_LANES examples is computed one level at a time, the
+ * loop over the examples having no branches.
+ *
+ * @param tree The table
+ * @param rows Attribute values of the examples, one example after another
+ * @param count Count of examples
+ * @param classes Output: id of class (or -1) for each example
+ */
+void oblivious_classify_batch(const struct oblivious_tree *tree,
+		const int *rows, int count, int *classes);
+
+/**
+ * @brief Frees the table of an oblivious classifier.
+ *
+ * @param ptr Pointer to the table.
+ */
+void free_oblivious_tree(struct oblivious_tree *ptr);
+
+/**
+ * @brief Frees the binary tree.
+ *
+ * @param ptr Pointer to the tree.
+ */
+void free_batch_tree(struct batch_tree *ptr);
+
+/**
+ * @brief Frees a profile.
+ *
+ * @param ptr Pointer to the profile.
+ */
+void free_profile(struct flat_profile *ptr);
+
+/**
+ * @brief Frees the flattened tree.
+ *
+ * @param ptr Pointer to the tree.
+ */
+void free_flat_tree(struct flat_tree *ptr);
+
+#endif
+
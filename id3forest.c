@@ -0,0 +1,139 @@
+/*!
+ * @file id3forest.c
+ * @brief Learning a forest of id3 classifiers.
+ * @author Mihai Maruseac (mihai@rosedu.org)
+ *
+ * @section DESCRIPTION
+ * IAUT1: ID3: Learning a forest of id3 classifiers.
+ *
+ * Contains the functions used to learn several classifiers from random
+ * samples of the same learning set (bagging), each node testing a random
+ * subset of the attributes. The forest classifies by majority vote.
+ *
+ * @section QUOTE
+ * The whole is greater than the sum of its parts. (Aristotle)
+ *
+ * @bug No known bugs.
+ */
+
+#include <math.h>
+
+#include "globals.h"
+#include "id3forest.h"
+#include "id3learn.h"
+
+/**
+ * @brief Work shared by the threads learning the trees of a forest.
+ */
+struct forest_work {
+	/** Learning options */
+	const struct forest_options *opts;
+	/** The description of the problem (prepared, read-only) */
+	const struct description *descr;
+	/** The learning set (prepared, read-only) */
+	const struct example_set *lset;
+	/** Count of attributes tested at each node */
+	int features;
+	/** The learned trees */
+	struct classifier **trees;
+};
+
+/**
+ * @brief Task learning one tree (see run_tasks).
+ *
+ * @param arg The struct forest_work
+ * @param index Index of tree
+ */
+static void learn_task(void *arg, int index);
+
+/**
+ * @brief Learns one tree of the forest from a bootstrap sample.
+ *
+ * @param work The forest
+ * @param index Index of the tree
+ * @return Classifier
+ */
+static struct classifier *learn_tree(const struct forest_work *work,
+		int index);
+
+int id3_forest_bootstrap_file(const struct forest_options *opts,
+		FILE *attr_file, FILE *learn_file, FILE *id3_file)
+{
+	struct forest_work work;
+	struct description *descr;
+	struct example_set *lset;
+	int i;
+
+	descr = read_description_file(attr_file);
+	CHECK(descr != NULL, nodescr);
+	lset = read_learning_file(learn_file, descr);
+	CHECK(lset != NULL, nolset);
+	CHECK(lset->N > 0, fail);
+
+	id3_prepare_set(descr, lset, opts->num_handle, opts->missing_handle,
+			opts->jobs);
+	work.opts = opts;
+	work.descr = descr;
+	work.lset = lset;
+	work.features = opts->features;
+	if (work.features == 0)
+		work.features = (int)ceil(sqrt(descr->M));
+	if (work.features > descr->M)
+		work.features = descr->M;
+	work.trees = calloc(opts->trees, sizeof(work.trees[0]));
+	run_tasks(opts->jobs, opts->trees, learn_task, &work);
+
+	write_forest_file(descr, work.trees, opts->trees, id3_file);
+
+	for (i = 0; i < opts->trees; i++)
+		free_classifier(work.trees[i]);
+	free(work.trees);
+	free_description(descr);
+	free_and_set_NULL(descr);
+	free_example_set(lset);
+	free_and_set_NULL(lset);
+	return EXIT_SUCCESS;
+
+fail:
+	free_example_set(lset);
+	free_and_set_NULL(lset);
+nolset:
+	free_description(descr);
+	free_and_set_NULL(descr);
+nodescr:
+	return set_error(EINVAL);
+}
+
+void learn_task(void *arg, int index)
+{
+	struct forest_work *work = arg;
+
+	work->trees[index] = learn_tree(work, index);
+}
+
+struct classifier *learn_tree(const struct forest_work *work, int index)
+{
+	struct learn_state st;
+	struct classifier *cls;
+	int i, N, *weight;
+
+	N = work->lset->N;
+	st.descr = work->descr;
+	st.lset = work->lset;
+	st.num_handle = work->opts->num_handle;
+	st.features = work->features;
+	/* spread the seeds, close seeds give close first numbers */
+	st.seed = work->opts->seed ^ (2654435761u * (index + 1));
+	st.max_depth = 0;
+
+	/* draw N examples with replacement */
+	weight = calloc(N, sizeof(weight[0]));
+	for (i = 0; i < N; i++)
+		weight[rand_r(&st.seed) % N]++;
+	st.weight = weight;
+
+	cls = id3_learn_tree(&st);
+	free(weight);
+	return cls;
+}
+
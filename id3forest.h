@@ -0,0 +1,65 @@
+/*!
+ * @file id3forest.h
+ * @brief Learning a forest of id3 classifiers.
+ * @author Mihai Maruseac (mihai@rosedu.org)
+ *
+ * @section DESCRIPTION
+ * IAUT1: ID3: Learning a forest of id3 classifiers.
+ *
+ * Contains the functions used to learn several classifiers from random
+ * samples of the same learning set (bagging), each node testing a random
+ * subset of the attributes. The forest classifies by majority vote.
+ *
+ * @section QUOTE
+ * The whole is greater than the sum of its parts. (Aristotle)
+ *
+ * @bug No known bugs.
+ */
+
+#ifndef _ID3FOREST_H
+#define _ID3FOREST_H
+
+#include "globals.h"
+
+/**
+ * @brief Options of the forest learning process.
+ */
+struct forest_options {
+	/** How to handle numeric arguments */
+	int num_handle;
+	/** How to handle missing arguments */
+	int missing_handle;
+	/** Count of trees */
+	int trees;
+	/** Count of attributes tested at each node (0 for the square root of
+	 * the count of attributes)
+	 */
+	int features;
+	/** Count of threads learning trees */
+	int jobs;
+	/** Seed of the random samples */
+	unsigned seed;
+};
+
+/**
+ * @brief Bootstraps the learning of a forest by reading data from the input
+ * files.
+ *
+ * The learning set is read, its missing values filled and its numeric
+ * attributes discretized only once. The trees are then learned by up to
+ * opts->jobs threads, all of them reading the same set: the sample of each
+ * tree is a vector counting how many times each example was drawn, not a
+ * copy of the examples. Each tree has its own seed, derived from
+ * opts->seed, thus the forest doesn't depend on the number of jobs.
+ *
+ * @param opts Learning options.
+ * @param attr_file File containing the attribute description.
+ * @param learn_file File containing the example set.
+ * @param id3_file File used to output the forest.
+ * @return The exit code for the learning process.
+ */
+int id3_forest_bootstrap_file(const struct forest_options *opts,
+		FILE *attr_file, FILE *learn_file, FILE *id3_file);
+
+#endif
+
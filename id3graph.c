@@ -128,6 +128,61 @@ static void g_sch_cond(const struct description *descr,
 static void g_sch_if(const struct description *descr,
 		const struct classifier *cls, FILE *out, int level);
 
+/**
+ * @brief Outputs the classifier as a self-contained C source file.
+ *
+ * The file contains the names of the classes in a static table and a
+ * classify function doing the tests of the tree with if and switch
+ * statements.
+ *
+ * @param descr The description to use
+ * @param cls The classifier
+ * @param out Where to output
+ */
+static void graph_c(const struct description *descr,
+		const struct classifier *cls, FILE *out);
+
+/**
+ * @brief Prints the C statements classifying an example from a node.
+ *
+ * Leaves return the class, numeric nodes use a chain of if statements and
+ * discrete nodes use a switch statement.
+ *
+ * @param descr The description to use
+ * @param cls The classifier
+ * @param out Where to output
+ * @param level Level of indentation
+ */
+static void g_c_node(const struct description *descr,
+		const struct classifier *cls, FILE *out, int level);
+
+/**
+ * @brief Prints the indentation of a C statement.
+ *
+ * @param out Where to output
+ * @param level Level of indentation (count of tabs)
+ */
+static void g_c_indent(FILE *out, int level);
+
+/**
+ * @brief Prints a string as a C string literal.
+ *
+ * @param str The string
+ * @param out Where to output
+ */
+static void g_c_string(const char *str, FILE *out);
+
+/**
+ * @brief Prints a string inside a C comment.
+ *
+ * A space is put between the characters of each comment delimiter, thus the
+ * string can't close the comment (or open another one).
+ *
+ * @param str The string
+ * @param out Where to output
+ */
+static void g_c_comment(const char *str, FILE *out);
+
 /**
  * @brief Prints the content of the dot file.
  *
@@ -140,6 +195,17 @@ static void g_sch_if(const struct description *descr,
 static int dot_output(const struct description *descr,
 		const struct classifier *cls, FILE *out, int level);
 
+/**
+ * @brief Returns the name of the value of a branch of a discrete node.
+ *
+ * @param descr The description to use
+ * @param cls The classifier
+ * @param i Index of branch
+ * @return Name of value or "*" for the default branch
+ */
+static const char *value_name(const struct description *descr,
+		const struct classifier *cls, int i);
+
 int id3_output_graph(FILE *id3, FILE *out, int graph_mode)
 {
 	struct description *descr;
@@ -163,6 +229,14 @@ nodescr:
 	return set_error(EINVAL);
 }
 
+const char *value_name(const struct description *descr,
+		const struct classifier *cls, int i)
+{
+	if (cls->values[i] == CLS_ANY)
+		return "*";
+	return (char *)descr->attribs[cls->id]->ptr[cls->values[i]];
+}
+
 void graph_classifier(const struct description *descr,
 		const struct classifier *cls, int graph_mode, FILE *out)
 {
@@ -176,14 +250,18 @@ void graph_classifier(const struct description *descr,
 	case TREE_SCHEME:
 		graph_scheme(descr, cls, out);
 		break;
+	case TREE_C:
+		graph_c(descr, cls, out);
+		break;
 	}
 }
 
 void graph_ascii(const struct description *descr,
 		const struct classifier *cls, FILE *out, int level)
 {
+	const char *val;
 	int i, aid;
-	char *name, *val;
+	char *name;
 
 	aid = cls->id;
 	name = aid != -1 ? descr->attribs[aid]->name : "unknown";
@@ -205,9 +283,7 @@ void graph_ascii(const struct description *descr,
 		graph_ascii(descr, cls->cls[i], out, level + 1);
 	} else
 		for (i = 0; i < cls->C; i++) {
-			val = (char *)
-				descr->attribs[aid]->
-				ptr[cls->values[i]];
+			val = value_name(descr, cls, i);
 			fprintf(out, "%*c%s = %s\n", TABS * level + 1,
 					' ', name, val);
 			graph_ascii(descr, cls->cls[i], out, level + 1);
@@ -217,7 +293,8 @@ void graph_ascii(const struct description *descr,
 int dot_output(const struct description *descr,
 		const struct classifier *cls, FILE *out, int level)
 {
-	char *name, *dname, *aname;
+	const char *aname;
+	char *name, *dname;
 	int i, l, ll, type;
 
 	if (cls->C == 0) {
@@ -248,8 +325,7 @@ int dot_output(const struct description *descr,
 					"[fontsize=10];\n", name, l, dname,
 					ll, cls->values[i - 1]);
 		else {
-			aname = (char *)
-				descr->attribs[cls->id]->ptr[cls->values[i]];
+			aname = value_name(descr, cls, i);
 			fprintf(out, "%s%d -- %s%d[label=\"%s\"]"
 				"[fontsize=10];\n", name, l, dname, ll, aname);
 		}
@@ -304,13 +380,15 @@ void g_sch_dsc_branches(const struct description *descr,
 		const struct classifier *cls, FILE *out, int level)
 {
 	int i, aid;
-	char *val;
 
 	aid = cls->id;
 	for (i = 0; i < cls->C; i++) {
-		val = (char *)descr->attribs[aid]->ptr[cls->values[i]];
-		fprintf(out, "%*c((eqv? %s '%s) ", TABS * level, ' ',
-				descr->attribs[aid]->name, val);
+		if (cls->values[i] == CLS_ANY)
+			fprintf(out, "%*c(else ", TABS * level, ' ');
+		else
+			fprintf(out, "%*c((eqv? %s '%s) ", TABS * level, ' ',
+					descr->attribs[aid]->name,
+					value_name(descr, cls, i));
 		g_sch_print(descr, cls->cls[i], out, level);
 		fprintf(out, ")\n");
 	}
@@ -341,3 +419,127 @@ void graph_scheme(const struct description *descr,
 	g_sch_if(descr, cls, out, 0);
 }
 
+void g_c_indent(FILE *out, int level)
+{
+	for (; level; level--)
+		fputc('\t', out);
+}
+
+void g_c_string(const char *str, FILE *out)
+{
+	fputc('"', out);
+	for (; *str; str++) {
+		/* '?' too, so that no trigraph is formed */
+		if (*str == '"' || *str == '\\' || *str == '?')
+			fputc('\\', out);
+		fputc(*str, out);
+	}
+	fputc('"', out);
+}
+
+void g_c_comment(const char *str, FILE *out)
+{
+	for (; *str; str++) {
+		fputc(*str, out);
+		if ((str[0] == '*' && str[1] == '/') ||
+				(str[0] == '/' && str[1] == '*'))
+			fputc(' ', out);
+	}
+}
+
+void g_c_node(const struct description *descr,
+		const struct classifier *cls, FILE *out, int level)
+{
+	int i, aid;
+	char *name;
+
+	g_c_indent(out, level);
+	if (cls->C == 0) {
+		fprintf(out, "return %d; /* ", cls->id);
+		g_c_comment(cls->id != -1 ? descr->classes[cls->id] :
+				"unknown", out);
+		fprintf(out, " */\n");
+		return;
+	}
+
+	aid = cls->id;
+	name = descr->attribs[aid]->name;
+	if (descr->attribs[aid]->type == NUMERIC) {
+		for (i = 0; i < cls->C - 1; i++) {
+			if (i)
+				g_c_indent(out, level);
+			fprintf(out, "if (attrs[%d] < %d) { /* ", aid,
+					cls->values[i]);
+			g_c_comment(name, out);
+			fprintf(out, " */\n");
+			g_c_node(descr, cls->cls[i], out, level + 1);
+			g_c_indent(out, level);
+			fprintf(out, "}\n");
+		}
+		g_c_node(descr, cls->cls[i], out, level);
+		return;
+	}
+
+	fprintf(out, "switch (attrs[%d]) { /* ", aid);
+	g_c_comment(name, out);
+	fprintf(out, " */\n");
+	for (i = 0; i < cls->C; i++) {
+		g_c_indent(out, level);
+		if (cls->values[i] == CLS_ANY) {
+			fprintf(out, "default:\n");
+		} else {
+			fprintf(out, "case %d: /* ", cls->values[i]);
+			g_c_comment(value_name(descr, cls, i), out);
+			fprintf(out, " */\n");
+		}
+		g_c_node(descr, cls->cls[i], out, level + 1);
+	}
+	g_c_indent(out, level);
+	fprintf(out, "}\n");
+	g_c_indent(out, level);
+	fprintf(out, "return -1;\n");
+}
+
+void graph_c(const struct description *descr,
+		const struct classifier *cls, FILE *out)
+{
+	int i, j;
+
+	fprintf(out, "/*\n * id3 classifier\n *\n * Attributes (indexes in the"
+			" attrs vector given to classify):\n");
+	for (i = 0; i < descr->M; i++) {
+		fprintf(out, " *\t%d: ", i);
+		g_c_comment(descr->attribs[i]->name, out);
+		if (descr->attribs[i]->type == NUMERIC) {
+			fprintf(out, " (numeric)\n");
+			continue;
+		}
+		fprintf(out, " (discrete:");
+		for (j = 0; j < descr->attribs[i]->C; j++) {
+			fprintf(out, " %d = ", j);
+			g_c_comment((char *)descr->attribs[i]->ptr[j], out);
+		}
+		fprintf(out, ")\n");
+	}
+	fprintf(out, " */\n\n");
+
+	fprintf(out, "#define ID3_CLASSES %d\n\n", descr->K);
+	fprintf(out, "static const char *const id3_classes[ID3_CLASSES] = {\n");
+	for (i = 0; i < descr->K; i++) {
+		fprintf(out, "\t");
+		g_c_string(descr->classes[i], out);
+		fprintf(out, ",\n");
+	}
+	fprintf(out, "};\n\n");
+
+	fprintf(out, "/* Returns the name of a class or \"unknown\" for -1. */\n"
+			"const char *class_name(int id)\n{\n"
+			"\tif (id < 0 || id >= ID3_CLASSES)\n"
+			"\t\treturn \"unknown\";\n"
+			"\treturn id3_classes[id];\n}\n\n");
+
+	fprintf(out, "/* Returns the class of an example (-1 if unknown). */\n"
+			"int classify(const int *attrs)\n{\n");
+	g_c_node(descr, cls, out, 1);
+	fprintf(out, "}\n");
+}
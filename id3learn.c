@@ -17,9 +17,11 @@
  */
 
 #include "globals.h"
+#include "id3dag.h"
 #include "id3learn.h"
 #include "id3math.h"
 #include "id3missing.h"
+#include "id3prune.h"
 
 /**
  * @brief
@@ -28,24 +30,222 @@
 #define EPS (1e-4)
 
 /**
- * @brief
- * Static value used to remember the last tag used.
+ * @brief Class of a group of examples of several classes.
+ */
+#define CLS_MIXED -1
+
+/**
+ * @brief Count of copies of an example in the sample learned from.
+ *
+ * @param st State of the learning process
+ * @param i Index of example
+ */
+#define WEIGHT(st, i) ((st)->weight ? (st)->weight[i] : 1)
+
+/**
+ * @brief Structure representing the nodes of one level of the tree being
+ * learned, whose tests are not chosen yet.
+ */
+struct learn_level {
+	/** Count of nodes */
+	int count;
+	/** Allocated nodes */
+	int size;
+	/** The nodes (leaves until their test is chosen) */
+	struct classifier **nodes;
+	/** Count of examples of class k reaching node f, at index f * K + k */
+	int *classes;
+};
+
+/**
+ * @brief Structure representing the examples of the nodes of a level sorted
+ * by each numeric attribute (used with NUM_LOCAL).
  */
-static int last_tag;
+struct sorted_lists {
+	/** Count of examples in each list */
+	int count;
+	/** Examples sorted by attribute a, at index a (NULL if discrete) */
+	int **rows;
+	/** The examples of node f are at indexes start[f] to start[f + 1] - 1
+	 * of each list
+	 */
+	int *start;
+	/** Room used while splitting a list */
+	int *tmp;
+};
 
 /**
- * @brief The learning process (wrapper function).
+ * @brief Returns the count of branches of a node testing an attribute.
  *
- * This function is recursive. The ending condition is done by the tag
- * variable, which is used to filter the remaining examples (and to create the
- * id3 tree nodes).
+ * @param st State of the learning process.
+ * @param id Id of attribute
+ * @return Count of branches
+ */
+static int attr_branches(const struct learn_state *st, int id);
+
+/**
+ * @brief Returns the branch of a node taken by a value.
  *
- * @param descr The description of the problem.
- * @param lset The learning set.
- * @param tag Tag used to filter the learning set.
+ * @param st State of the learning process.
+ * @param id Id of attribute tested by the node
+ * @param limit Threshold of the node (numeric attributes with NUM_LOCAL)
+ * @param v The value
+ * @return Index of branch
+ */
+static int node_branch(const struct learn_state *st, int id, int limit,
+		int v);
+
+/**
+ * @brief Builds the sorted lists of the root from the indexes of the
+ * numeric attributes.
+ *
+ * @param st State of the learning process (filter gives the examples left
+ * out)
+ * @param lists Output: the lists
+ */
+static void sort_lists(const struct learn_state *st,
+		struct sorted_lists *lists);
+
+/**
+ * @brief Chooses the threshold of each numeric attribute at each node of a
+ * level and counts the examples of each class on each side of it.
+ *
+ * Each list is scanned once, the counts of the examples below the threshold
+ * being updated as the threshold moves up. Only thresholds between distinct
+ * values are tried.
+ *
+ * @param st State of the learning process.
+ * @param lists The sorted lists of the level
+ * @param level The level
+ * @param offsets Index of the counts of each attribute in the counts of a
+ * node
+ * @param stride Count of counts of a node
+ * @param counts Output: counts of the numeric attributes, as computed by
+ * count_level for the other ones
+ * @param limits Output: threshold of attribute a at node f, at index
+ * f * M + a
+ */
+static void local_splits(const struct learn_state *st,
+		const struct sorted_lists *lists,
+		const struct learn_level *level, const int *offsets,
+		int stride, int *counts, int *limits);
+
+/**
+ * @brief Splits the sorted lists among the nodes of the next level.
+ *
+ * @param st State of the learning process (filter gives the node of the
+ * next level of each example)
+ * @param lists The lists
+ * @param count Count of nodes of the next level
+ */
+static void split_lists(const struct learn_state *st,
+		struct sorted_lists *lists, int count);
+
+/**
+ * @brief Frees the sorted lists.
+ *
+ * @param st State of the learning process.
+ * @param lists The lists
+ */
+static void free_lists(const struct learn_state *st,
+		struct sorted_lists *lists);
+
+/**
+ * @brief Counts the examples of each class taking each branch of a split on
+ * each attribute, for all the nodes of a level, in one pass.
+ *
+ * @param st State of the learning process (filter gives the node of each
+ * example)
+ * @param offsets Index of the counts of each attribute in the counts of a
+ * node
+ * @param stride Count of counts of a node
+ * @param counts Output: count of examples of class k of node f taking branch
+ * b of the split on attribute a, at index f * stride + offsets[a] + b * K +
+ * k (must be initialized with 0 by the caller; with NUM_LOCAL, numeric
+ * attributes are skipped)
+ */
+static void count_level(const struct learn_state *st, const int *offsets,
+		int stride, int *counts);
+
+/**
+ * @brief Chooses the attribute to split a node on.
+ *
+ * @param st State of the learning process.
+ * @param classes Count of examples of the node in each class.
+ * @param counts Counts of the node (as computed by count_level)
+ * @param offsets Index of the counts of each attribute in counts
+ * @param order Room for the order in which the attributes are tested
+ * @return Id of attribute or -1 if no split gives any gain
+ */
+static int choose_split(struct learn_state *st, const int *classes,
+		const int *counts, const int *offsets, int *order);
+
+/**
+ * @brief Computes the expected average information obtained by splitting on
+ * an attribute (E_A), from the counts of the split.
+ *
+ * @param K Count of classes
+ * @param C Count of branches
+ * @param counts Count of examples of class k in branch b, at index b * K + k
+ * @param count Count of examples
+ * @return E_A
+ */
+static double split_entropy(int K, int C, const int *counts, int count);
+
+/**
+ * @brief Splits a node of a level on an attribute.
+ *
+ * The branches with examples of several classes are added to the next level,
+ * the other ones are leaves: the class of the examples or, for empty
+ * branches, the majority class of the node. Values of a discrete attribute
+ * not taken by any example share a single default branch, the last one.
+ *
+ * @param st State of the learning process.
+ * @param cls The node
+ * @param id Id of attribute
+ * @param limit Threshold of the split (numeric attributes with NUM_LOCAL)
+ * @param counts Count of examples of class k taking branch b, at index
+ * b * K + k
+ * @param next The next level
+ * @param route Output: index in the next level of the node reached by each
+ * branch (by branch_index), -1 for leaves (must be initialized by the caller)
+ */
+static void split_node(struct learn_state *st, struct classifier *cls,
+		int id, int limit, const int *counts,
+		struct learn_level *next, int *route);
+
+/**
+ * @brief Returns the node reached by a branch.
+ *
+ * @param st State of the learning process.
+ * @param classes Count of examples of each class taking the branch
+ * @param next The next level, the node is added to it if it is not a leaf
+ * @param route Output: index of the node in the next level (unchanged for
+ * leaves)
+ * @return The node
+ */
+static struct classifier *branch_node(struct learn_state *st,
+		const int *classes, struct learn_level *next, int *route);
+
+/**
+ * @brief Numbers the nodes of a tree in preorder.
+ *
+ * @param cls The tree
+ * @param tag Tag of the root
+ * @return First tag after the ones of the tree
+ */
+static int number_tags(struct classifier *cls, int tag);
+
+/**
+ * @brief Computes the information given by a set of examples (I_{DT}) from
+ * the count of examples in each class.
+ *
+ * @param K Count of classes
+ * @param classes Count of examples in each class
+ * @param count Count of examples
+ * @return I_{DT}
  */
-static struct classifier *id3_learn(const struct description *descr,
-		const struct example_set *lset, int tag);
+static double id3_I_counts(int K, const int *classes, int count);
 
 /**
  * @brief Fills the missing spots.
@@ -58,7 +258,19 @@ static void id3_treat_missing(const struct description *descr,
 		struct example_set *lset, int missing_handle);
 
 /**
- * @brief Builds indexes for numeric attributes.
+ * @brief Work shared by the threads preparing the numeric attributes.
+ */
+struct discr_work {
+	/** The description of the problem */
+	const struct description *descr;
+	/** The learning set */
+	const struct example_set *lset;
+	/** How to handle numeric arguments */
+	int num_handle;
+};
+
+/**
+ * @brief Builds the index of a numeric attribute.
  *
  * The indexes are used to implement handling of numeric attributes and to
  * sort the input set, if needed. Subsets of the input will keep the same
@@ -66,74 +278,67 @@ static void id3_treat_missing(const struct description *descr,
  *
  * @param descr The description of the problem.
  * @param lset The learning set
+ * @param index Index of attribute
  */
-static void id3_build_index(const struct description *descr,
-		const struct example_set *lset);
+static void id3_attr_index(const struct description *descr,
+		const struct example_set *lset, int index);
 
 /**
  * @brief Starts the discretization process for each numeric attribute.
  *
- * It assumes that the indexes are computed and destroys them afterwards,
- * replacing them with tests for the discrete bins.
+ * The index of each attribute is built and then destroyed, being replaced
+ * with tests for the discrete bins (with NUM_LOCAL the index is kept). Each
+ * attribute is prepared on its own, thus several of them are prepared at
+ * the same time.
  *
  * @param descr The description of the problem.
  * @param lset The learning set
  * @param num_handle How to handle the numeric arguments: full discretization
  * or binary discretization.
+ * @param jobs Count of attributes prepared at the same time
  */
 static void id3_discretization(const struct description *descr,
-		const struct example_set *lset, int num_handle);
+		const struct example_set *lset, int num_handle, int jobs);
 
 /**
- * @brief Computes the count of eamples having a specified filter value.
+ * @brief Task preparing one attribute if numeric (see run_tasks).
  *
- * @param lset The learning set
- * @param tag The filter value
- * @return Count of examples with specified tag
+ * @param arg The struct discr_work
+ * @param index Index of attribute
  */
-static int id3_filtered_count(const struct example_set *lset, int tag);
+static void id3_discr_task(void *arg, int index);
 
 /**
- * @brief Computes the information given by a set of examples (I_{DT})
+ * @brief Computes the count of eamples having a specified tag.
  *
- * @param descr The description of the problem
- * @param lset The learning set
- * @param tag Tag to filter the learning set
- * @param count Count of filtered values
- * @return I_{DT}
+ * @param tags Tag of each example
+ * @param N Count of examples
+ * @param tag The tag
+ * @return Count of examples with specified tag
  */
-static double id3_I_decision_tree(const struct description *descr,
-		const struct example_set *lset, int tag, int count);
+static int id3_filtered_count(const int *tags, int N, int tag);
 
 /**
- * @brief Computes the expected average information obtained by splitting on a
- * numeric attribute.
+ * @brief Computes the information given by a set of examples (I_{DT})
  *
  * @param descr The description of the problem
  * @param lset The learning set
- * @param index Index of attribute
+ * @param tags Tag of each example
  * @param tag Tag to filter the learning set
  * @param count Count of filtered values
- * @return E_A
+ * @return I_{DT}
  */
-static double test_split_numeric(const struct description *descr,
-		const struct example_set *lset,
-		int index, int tag, int count);
+static double id3_I_decision_tree(const struct description *descr,
+		const struct example_set *lset, const int *tags, int tag,
+		int count);
 
 /**
- * @brief Computes the expected average information obtained by splitting on a
- * discrete attribute.
+ * @brief Returns the count of branches of a split on an attribute.
  *
- * @param descr The description of the problem
- * @param lset The learning set
- * @param index Index of attribute
- * @param tag Tag to filter the learning set
- * @param count Count of filtered values
- * @return E_A
+ * @param attr The attribute (numeric attributes are discretized)
+ * @return Count of branches
  */
-static double test_split_discrete(const struct description *descr,
-		const struct example_set *lset,
-		int index, int tag, int count);
+static int split_branches(const struct attribute *attr);
 
 /**
  * @brief Computes the entropy obtained by splitting a numeric domain in two
@@ -154,13 +359,17 @@ static double split_e(const struct description *descr,
  * the level of discretization to use when doing full discretization of
  * numeric attributes.
  *
+ * The examples are tagged with their bin in tags, not in the examples, so
+ * that several attributes can be discretized at the same time.
+ *
  * @param descr The description of the problem
  * @param lset The learning set
  * @param index Index of attribute
+ * @param tags Room for the tag of each example
  * @return estimation of entropy gain
  */
 static double id3_get_split_value(const struct description *descr,
-		const struct example_set *lset, int index);
+		const struct example_set *lset, int index, int *tags);
 
 /**
  * @brief Does the full discretization of the numeric attributes.
@@ -187,47 +396,106 @@ static void id3_attr_full_discr(const struct description *descr,
  * @brief Computes the candidates for the discretization of numeric
  * attributes.
  *
- * Each candidate will be the point where the class changes.
+ * The examples are grouped by value. A candidate is the value of a group
+ * (the limit below which the previous groups fall) unless this group and
+ * the previous one hold examples of the same single class: such a cut never
+ * gives the lowest entropy (Fayyad and Irani), thus it is not tried.
  *
  * @param descr The description of the problem
  * @param lset The learning set
  * @param index Index of attribute
  * @param candidates Candidates for levels of discretizations
- * @return Candidate count
+ * @return Candidate count (0 if there is no cut point, e.g. a single value)
  */
 static int compute_candidates(const struct description *descr,
 		const struct example_set *lset, int index, int *candidates);
 
 /**
- * @brief Returns an unknown class node for a classifier.
- *
- * This is obtained only when the learning set is too complex to learn.
+ * @brief Returns a leaf node for a classifier.
  *
- * @param tag Tag used to filter the learning set.
+ * @param tag Tag of the node.
+ * @param id Id of class (-1 if unknown).
  * @return Classifier
  */
-struct classifier *get_default(int tag);
+static struct classifier *get_leaf(int tag, int id);
+
+/**
+ * @brief Splits the nodes of the last level of an oblivious tree on an
+ * attribute.
+ *
+ * Nodes with a single class become leaves. The examples are moved to the
+ * nodes of the new level.
+ *
+ * @param st State of the learning process (filter gives the index of the
+ * node of each example in the level, -1 if the example reached a leaf)
+ * @param level Nodes of the last level, replaced by the nodes of the new one
+ * @param F Count of nodes of the last level
+ * @param id Id of attribute
+ * @param counts Count of examples of class k taking branch b of node f, at
+ * index (f * C + b) * K + k
+ * @return Count of nodes of the new level
+ */
+static int split_level(struct learn_state *st, struct classifier **level,
+		int F, int id, const int *counts);
 
-int id3_learn_bootstrap_file(int num_handle, int missing_handle,
+/**
+ * @brief Returns the majority class of a set of examples.
+ *
+ * @param K Count of classes
+ * @param classes Count of examples in each class
+ * @return Id of class (the first one for ties)
+ */
+static int majority_class(int K, const int *classes);
+
+/**
+ * @brief Returns the branch of a split taken by a value.
+ *
+ * @param attr The attribute split on (numeric attributes are discretized)
+ * @param v The value
+ * @return Index of branch
+ */
+static int branch_index(const struct attribute *attr, int v);
+
+int id3_learn_bootstrap_file(const struct learn_options *opts,
 		FILE *attr_file, FILE *learn_file, FILE *id3_file)
 {
+	struct example_set *lset, *hset;
 	struct description *descr;
-	struct example_set *lset;
 	struct classifier *cls;
+	struct learn_state st;
 
 	descr = read_description_file(attr_file);
 	CHECK(descr != NULL, nodescr);
 	lset = read_learning_file(learn_file, descr);
 	CHECK(lset != NULL, nolset);
 
-	/* fill in missing arguments */
-	id3_treat_missing(descr, lset, missing_handle);
-	/* built indexes for numeric arguments */
-	id3_build_index(descr, lset);
-	/* discretization for numeric arguments */
-	id3_discretization(descr, lset, num_handle);
-	/* start the learning process */
-	cls = id3_learn(descr, lset, 0);
+	id3_prepare_set(descr, lset, opts->num_handle, opts->missing_handle,
+			opts->jobs);
+	st.descr = descr;
+	st.lset = lset;
+	st.weight = NULL;
+	st.num_handle = opts->num_handle;
+	st.features = 0;
+	st.seed = 0;
+	st.max_depth = opts->max_depth;
+	if (opts->oblivious)
+		cls = id3_learn_oblivious(&st);
+	else
+		cls = id3_learn_tree(&st);
+	if (opts->prune != PRUNE_NONE) {
+		hset = NULL;
+		if (opts->prune == PRUNE_REP) {
+			hset = read_learning_file(opts->holdout, descr);
+			CHECK(hset != NULL, nohset);
+		}
+		cls = id3_prune(descr, lset, hset, cls, opts->prune);
+		if (hset) {
+			free_example_set(hset);
+			free_and_set_NULL(hset);
+		}
+	}
+	if (opts->dag)
+		cls = share_subtrees(cls);
 	/* write results */
 	write_id3_temp_file(descr, cls, id3_file);
 
@@ -239,6 +507,10 @@ int id3_learn_bootstrap_file(int num_handle, int missing_handle,
 
 	return EXIT_SUCCESS;
 
+nohset:
+	free_classifier(cls);
+	free_example_set(lset);
+	free_and_set_NULL(lset);
 nolset:
 	free_description(descr);
 	free_and_set_NULL(descr);
@@ -246,27 +518,172 @@ nodescr:
 	return set_error(EINVAL); /* invalid file received */
 }
 
-int id3_filtered_count(const struct example_set *lset, int tag)
+struct classifier *id3_learn_set(const struct description *descr,
+		struct example_set *lset, int num_handle, int missing_handle)
+{
+	struct learn_state st;
+
+	id3_prepare_set(descr, lset, num_handle, missing_handle, 1);
+	st.descr = descr;
+	st.lset = lset;
+	st.weight = NULL;
+	st.num_handle = num_handle;
+	st.features = 0;
+	st.seed = 0;
+	st.max_depth = 0;
+	return id3_learn_tree(&st);
+}
+
+void id3_prepare_set(const struct description *descr,
+		struct example_set *lset, int num_handle, int missing_handle,
+		int jobs)
+{
+	/* fill in missing arguments */
+	id3_treat_missing(descr, lset, missing_handle);
+	/* indexes and discretization for numeric arguments */
+	id3_discretization(descr, lset, num_handle, jobs);
+}
+
+struct classifier *id3_learn_tree(struct learn_state *st)
+{
+	const struct description *descr = st->descr;
+	const struct example_set *lset = st->lset;
+	int i, f, b, C, K, M, stride, branches, depth, *offsets, *counts,
+	    *order, *route, *tests, *limits;
+	struct learn_level level, next, tmp;
+	struct sorted_lists lists;
+	struct classifier *root;
+
+	K = descr->K;
+	M = descr->M;
+	offsets = calloc(M, sizeof(offsets[0]));
+	for (i = 0, stride = 0, branches = 0; i < M; i++) {
+		C = attr_branches(st, i);
+		offsets[i] = stride;
+		stride += C * K;
+		if (branches < C)
+			branches = C;
+	}
+	order = calloc(M, sizeof(order[0]));
+	counts = NULL;
+	route = NULL;
+	tests = NULL;
+	limits = NULL;
+
+	st->filter = calloc(lset->N, sizeof(st->filter[0]));
+	memset(&next, 0, sizeof(next));
+	memset(&level, 0, sizeof(level));
+	root = get_leaf(0, -1);
+	level.count = level.size = 1;
+	level.nodes = calloc(1, sizeof(level.nodes[0]));
+	level.nodes[0] = root;
+	level.classes = calloc(K, sizeof(level.classes[0]));
+	for (i = 0; i < lset->N; i++) {
+		if (WEIGHT(st, i) == 0)
+			st->filter[i] = -1;
+		level.classes[lset->examples[i]->class_id] += WEIGHT(st, i);
+	}
+	if (st->num_handle == NUM_LOCAL)
+		sort_lists(st, &lists);
+
+	for (depth = 0; level.count; depth++) {
+		/* the nodes at the depth limit give their majority class */
+		if (st->max_depth && depth == st->max_depth) {
+			for (f = 0; f < level.count; f++)
+				level.nodes[f]->id = majority_class(K,
+						level.classes + f * K);
+			break;
+		}
+
+		counts = realloc(counts, (size_t)level.count * stride *
+				sizeof(counts[0]));
+		memset(counts, 0, (size_t)level.count * stride *
+				sizeof(counts[0]));
+		route = realloc(route, level.count * branches *
+				sizeof(route[0]));
+		tests = realloc(tests, level.count * sizeof(tests[0]));
+		limits = realloc(limits, (size_t)level.count * M *
+				sizeof(limits[0]));
+		/* only numeric attributes under NUM_LOCAL have a limit */
+		memset(limits, 0, (size_t)level.count * M * sizeof(limits[0]));
+		count_level(st, offsets, stride, counts);
+		if (st->num_handle == NUM_LOCAL)
+			local_splits(st, &lists, &level, offsets, stride,
+					counts, limits);
+
+		next.count = 0;
+		for (f = 0; f < level.count; f++) {
+			for (b = 0; b < branches; b++)
+				route[f * branches + b] = -1;
+			tests[f] = choose_split(st, level.classes + f * K,
+					counts + f * stride, offsets, order);
+			/* no gain: the node stays an unknown class leaf */
+			SKIPIF(tests[f] == -1);
+			split_node(st, level.nodes[f], tests[f],
+					limits[f * M + tests[f]],
+					counts + f * stride + offsets[tests[f]],
+					&next, route + f * branches);
+		}
+
+		/* move the examples to the nodes of the next level */
+		for (i = 0; i < lset->N; i++) {
+			f = st->filter[i];
+			SKIPIF(f == -1);
+			if (tests[f] == -1) {
+				st->filter[i] = -1;
+				continue;
+			}
+			b = node_branch(st, tests[f], limits[f * M + tests[f]],
+					lset->examples[i]->attr_ids[tests[f]]);
+			st->filter[i] = route[f * branches + b];
+		}
+		if (st->num_handle == NUM_LOCAL)
+			split_lists(st, &lists, next.count);
+
+		tmp = level;
+		level = next;
+		next = tmp;
+	}
+	st->last_tag = number_tags(root, 0) - 1;
+
+	free(level.nodes);
+	free(level.classes);
+	free(next.nodes);
+	free(next.classes);
+	free(offsets);
+	free(order);
+	free(counts);
+	free(route);
+	free(tests);
+	free(limits);
+	if (st->num_handle == NUM_LOCAL)
+		free_lists(st, &lists);
+	st->filter = free_and_set_NULL(st->filter);
+	return root;
+}
+
+int id3_filtered_count(const int *tags, int N, int tag)
 {
 	int c, i;
 
 	c = 0;
-	for (i = 0; i < lset->N; i++)
-		if (lset->examples[i]->filter == tag)
+	for (i = 0; i < N; i++)
+		if (tags[i] == tag)
 			c++;
 
 	return c;
 }
 
 double id3_I_decision_tree(const struct description *descr,
-		const struct example_set *lset, int tag, int count)
+		const struct example_set *lset, const int *tags, int tag,
+		int count)
 {
 	int i, n, j;
 	float s;
 
 	for (i = 0, s = 0; i < descr->K; i++) {
 		for (j = 0, n = 0; j < lset->N; j++) {
-			SKIPIF(lset->examples[j]->filter != tag);
+			SKIPIF(tags[j] != tag);
 			INCRIF(lset->examples[j]->class_id == i, n);
 		}
 		s += entropy(DIV(n, count));
@@ -275,228 +692,533 @@ double id3_I_decision_tree(const struct description *descr,
 	return s;
 }
 
-double test_split_numeric(const struct description *descr,
-		const struct example_set *lset,
-		int index, int tag, int count)
+double id3_I_counts(int K, const int *classes, int count)
 {
-	int i, c, aid, j, k, cc;
-	double id3e, id3i;
+	float s;
+	int i;
 
-	for (i = 0, id3e = 0; i < descr->attribs[index]->C; i++) {
-		for (j = 0, c = 0; j < lset->N; j++) {
-			SKIPIF(lset->examples[j]->filter != tag);
-			aid = lset->examples[j]->attr_ids[index];
-			SKIPIF(aid >= descr->attribs[index]->ptr[i]);
-			SKIPIF(i && aid < descr->attribs[index]->ptr[i-1]);
-			c++;
+	/* accumulated in the same order as id3_I_decision_tree */
+	for (i = 0, s = 0; i < K; i++)
+		s += entropy(DIV(classes[i], count));
+
+	return s;
+}
+
+int split_branches(const struct attribute *attr)
+{
+	return attr->type == NUMERIC ? attr->C + 1 : attr->C;
+}
+
+int attr_branches(const struct learn_state *st, int id)
+{
+	const struct attribute *attr = st->descr->attribs[id];
+
+	if (st->num_handle == NUM_LOCAL && attr->type == NUMERIC)
+		return 2;
+	return split_branches(attr);
+}
+
+int node_branch(const struct learn_state *st, int id, int limit, int v)
+{
+	const struct attribute *attr = st->descr->attribs[id];
+
+	if (st->num_handle == NUM_LOCAL && attr->type == NUMERIC)
+		return v >= limit;
+	return branch_index(attr, v);
+}
+
+void sort_lists(const struct learn_state *st, struct sorted_lists *lists)
+{
+	const struct description *descr = st->descr;
+	int a, i, j, N;
+
+	N = st->lset->N;
+	lists->rows = calloc(descr->M, sizeof(lists->rows[0]));
+	lists->start = calloc(2, sizeof(lists->start[0]));
+	lists->tmp = calloc(N, sizeof(lists->tmp[0]));
+	lists->count = 0;
+	for (a = 0; a < descr->M; a++) {
+		SKIPIF(descr->attribs[a]->type != NUMERIC);
+		lists->rows[a] = calloc(N, sizeof(lists->rows[a][0]));
+		for (i = 0, j = 0; i < N; i++) {
+			SKIPIF(st->filter[descr->attribs[a]->ptr[i]] == -1);
+			lists->rows[a][j++] = descr->attribs[a]->ptr[i];
 		}
-		SKIPIF(c == 0);
-		for (k = 0, id3i = 0; k < descr->K; k++) {
-			for (j = 0, cc = 0; j < lset->N; j++) {
-				SKIPIF(lset->examples[j]->filter != tag);
-				aid = lset->examples[j]->attr_ids[index];
-				SKIPIF(aid >= descr->attribs[index]->ptr[i]);
-				SKIPIF(i &&
-					aid < descr->attribs[index]->ptr[i-1]);
-				INCRIF(lset->examples[j]->class_id == k, cc);
+		lists->count = j;
+	}
+	lists->start[1] = lists->count;
+}
+
+void local_splits(const struct learn_state *st,
+		const struct sorted_lists *lists,
+		const struct learn_level *level, const int *offsets,
+		int stride, int *counts, int *limits)
+{
+	const struct description *descr = st->descr;
+	const struct example *ex;
+	const int *classes;
+	int a, f, j, k, K, M, count, prev, *left, *pair, *row;
+	double e, ebest;
+
+	K = descr->K;
+	M = descr->M;
+	left = calloc(K, sizeof(left[0]));
+	pair = calloc(2 * K, sizeof(pair[0]));
+	for (a = 0; a < M; a++) {
+		SKIPIF(lists->rows[a] == NULL);
+		for (f = 0; f < level->count; f++) {
+			classes = level->classes + f * K;
+			row = counts + (size_t)f * stride + offsets[a];
+			for (k = 0, count = 0; k < K; k++) {
+				count += classes[k];
+				left[k] = 0;
+				/* no threshold: every example below it */
+				row[k] = classes[k];
+				row[K + k] = 0;
+			}
+			limits[f * M + a] = 0;
+
+			ebest = -1;
+			prev = 0;
+			for (j = lists->start[f]; j < lists->start[f + 1]; j++) {
+				ex = st->lset->examples[lists->rows[a][j]];
+				if (j > lists->start[f] &&
+						ex->attr_ids[a] != prev) {
+					for (k = 0; k < K; k++) {
+						pair[k] = left[k];
+						pair[K + k] = classes[k] -
+							left[k];
+					}
+					e = split_entropy(K, 2, pair, count);
+					if (ebest < 0 || e < ebest) {
+						ebest = e;
+						memcpy(row, pair, 2 * K *
+							sizeof(pair[0]));
+						limits[f * M + a] =
+							ex->attr_ids[a];
+					}
+				}
+				left[ex->class_id] += WEIGHT(st,
+						lists->rows[a][j]);
+				prev = ex->attr_ids[a];
 			}
-			id3i += entropy(DIV(cc, c));
 		}
-		id3e += DIV(c, count) * id3i;
 	}
+	free(left);
+	free(pair);
+}
 
-	for (j = 0, c = 0; j < lset->N; j++) {
-		SKIPIF(lset->examples[j]->filter != tag);
-		aid = lset->examples[j]->attr_ids[index];
-		SKIPIF(aid < descr->attribs[index]->ptr[i-1]);
-		c++;
-	}
-	if (c == 0)
-		goto end;
-	for (k = 0, id3i = 0; k < descr->K; k++) {
-		for (j = 0, cc = 0; j < lset->N; j++) {
-			SKIPIF(lset->examples[j]->filter != tag);
-			aid = lset->examples[j]->attr_ids[index];
-			SKIPIF(aid < descr->attribs[index]->ptr[i-1]);
-			INCRIF(lset->examples[j]->class_id == k, cc);
+void split_lists(const struct learn_state *st, struct sorted_lists *lists,
+		int count)
+{
+	const struct description *descr = st->descr;
+	int a, i, j, f, *pos, *swap;
+
+	/* the examples of each node of the next level, in the same order */
+	lists->start = realloc(lists->start, (count + 1) *
+			sizeof(lists->start[0]));
+	memset(lists->start, 0, (count + 1) * sizeof(lists->start[0]));
+	for (i = 0; i < st->lset->N; i++)
+		if (st->filter[i] != -1)
+			lists->start[st->filter[i] + 1]++;
+	for (f = 0; f < count; f++)
+		lists->start[f + 1] += lists->start[f];
+
+	pos = calloc(count + 1, sizeof(pos[0]));
+	for (a = 0; a < descr->M; a++) {
+		SKIPIF(lists->rows[a] == NULL);
+		memcpy(pos, lists->start, (count + 1) * sizeof(pos[0]));
+		for (j = 0; j < lists->count; j++) {
+			i = lists->rows[a][j];
+			SKIPIF(st->filter[i] == -1);
+			lists->tmp[pos[st->filter[i]]++] = i;
 		}
-		id3i += entropy(DIV(cc, c));
+		swap = lists->rows[a];
+		lists->rows[a] = lists->tmp;
+		lists->tmp = swap;
 	}
-	id3e += DIV(c, count) * id3i;
+	lists->count = lists->start[count];
+	free(pos);
+}
 
-end:
-	return id3e;
+void free_lists(const struct learn_state *st, struct sorted_lists *lists)
+{
+	int a;
+
+	for (a = 0; a < st->descr->M; a++)
+		free(lists->rows[a]);
+	free(lists->rows);
+	free(lists->start);
+	free(lists->tmp);
 }
 
-double test_split_discrete(const struct description *descr,
-		const struct example_set *lset,
-		int index, int tag, int count)
+void count_level(const struct learn_state *st, const int *offsets,
+		int stride, int *counts)
 {
-	int i, c, j, k, cc;
-	double id3e, id3i;
+	const struct description *descr = st->descr;
+	const struct example_set *lset = st->lset;
+	const struct example *ex;
+	int i, a, K, *row;
 
-	for (i = 0, id3e = 0; i < descr->attribs[index]->C; i++) {
-		for (j = 0, c = 0; j < lset->N; j++) {
-			SKIPIF(lset->examples[j]->filter != tag);
-			SKIPIF(lset->examples[j]->attr_ids[index] != i);
-			c++;
-		}
-		SKIPIF(c == 0);
-		for (k = 0, id3i = 0; k < descr->K; k++) {
-			for (j = 0, cc = 0; j < lset->N; j++) {
-				SKIPIF(lset->examples[j]->filter != tag);
-				SKIPIF(lset->examples[j]->attr_ids[index] != i);
-				INCRIF(lset->examples[j]->class_id == k, cc);
-			}
-			id3i += entropy(DIV(cc, c));
+	K = descr->K;
+	for (i = 0; i < lset->N; i++) {
+		SKIPIF(st->filter[i] == -1);
+		ex = lset->examples[i];
+		row = counts + (size_t)st->filter[i] * stride + ex->class_id;
+		for (a = 0; a < descr->M; a++) {
+			SKIPIF(st->num_handle == NUM_LOCAL &&
+					descr->attribs[a]->type == NUMERIC);
+			row[offsets[a] + branch_index(descr->attribs[a],
+					ex->attr_ids[a]) * K] += WEIGHT(st, i);
 		}
-		id3e += DIV(c, count) * id3i;
 	}
-
-	return id3e;
 }
 
-struct classifier *id3_learn(const struct description *descr,
-		const struct example_set *lset, int tag)
+int choose_split(struct learn_state *st, const int *classes,
+		const int *counts, const int *offsets, int *order)
 {
+	const struct description *descr = st->descr;
+	int i, j, k, count, ibest;
 	double iad, gain, gbest, exp;
-	int i, ibest, count;
 
-	count = id3_filtered_count(lset, tag);
-	iad = id3_I_decision_tree(descr, lset, tag, count);
+	for (k = 0, count = 0; k < descr->K; k++)
+		count += classes[k];
+	iad = id3_I_counts(descr->K, classes, count);
+	for (i = 0; i < descr->M; i++)
+		order[i] = i;
 
 	gbest = 0.0l;
-	/* for each attribute */
+	ibest = -1;
+	/* for each attribute, in random order if only some are tested */
 	for (i = 0; i < descr->M; i++) {
-		if (descr->attribs[i]->type == NUMERIC)
-			exp = test_split_numeric(descr, lset, i, tag, count);
-		else
-			exp = test_split_discrete(descr, lset, i, tag, count);
+		if (i == st->features && ibest != -1)
+			break;
+		if (st->features) {
+			j = i + rand_r(&st->seed) % (descr->M - i);
+			k = order[i];
+			order[i] = order[j];
+			order[j] = k;
+		}
+		exp = split_entropy(descr->K, attr_branches(st, order[i]),
+				counts + offsets[order[i]], count);
 		gain = iad - exp;
 		if (gbest < gain && gain > EPS) {
 			gbest = gain;
-			ibest = i;
+			ibest = order[i];
 		}
 	}
+	return ibest;
+}
+
+double split_entropy(int K, int C, const int *counts, int count)
+{
+	int i, c, k;
+	double id3e, id3i;
+
+	for (i = 0, id3e = 0; i < C; i++) {
+		for (k = 0, c = 0; k < K; k++)
+			c += counts[i * K + k];
+		SKIPIF(c == 0);
+		for (k = 0, id3i = 0; k < K; k++)
+			id3i += entropy(DIV(counts[i * K + k], c));
+		id3e += DIV(c, count) * id3i;
+	}
 
-	if (gbest < EPS)
-		return get_default(tag);
-	return split_on(descr, lset, tag, ibest);
+	return id3e;
 }
 
-struct classifier *build_numeric_classifier(const struct description *descr,
-		const struct example_set *lset, struct classifier *cls,
-		int index)
+void split_node(struct learn_state *st, struct classifier *cls, int id,
+		int limit, const int *counts, struct learn_level *next,
+		int *route)
 {
-	int i, cc, kc;
+	const struct description *descr = st->descr;
+	const struct attribute *attr = descr->attribs[id];
+	int i, k, C, K, major, *sizes, *classes;
 
-	kc = 1;
-	cc = -1;
-	last_tag++;
-	for (i = 0; i < lset->N; i++) {
-		SKIPIF(lset->examples[i]->filter != cls->tag);
-		SKIPIF(index != cls->C - 1 &&
-			lset->examples[i]->attr_ids[cls->id] >=
-				cls->values[index]);
-		SKIPIF(index && lset->examples[i]->attr_ids[cls->id]
-				< cls->values[index - 1]);
-		if (lset->examples[i]->class_id != cc) {
-			if (cc != -1)
-				kc = 0;
-			else
-				cc = lset->examples[i]->class_id;
+	K = descr->K;
+	C = attr_branches(st, id);
+
+	/* the counts give the empty branches and the majority class */
+	sizes = calloc(C, sizeof(sizes[0]));
+	classes = calloc(K, sizeof(classes[0]));
+	for (i = 0; i < C; i++)
+		for (k = 0; k < K; k++) {
+			sizes[i] += counts[i * K + k];
+			classes[k] += counts[i * K + k];
 		}
-		lset->examples[i]->filter = last_tag;
+	major = majority_class(K, classes);
+
+	cls->id = id;
+	cls->values = calloc(C, sizeof(cls->values[0]));
+	cls->cls = calloc(C, sizeof(cls->cls[0]));
+
+	if (attr->type == NUMERIC) {
+		/* intervals are positional, empty ones get a leaf */
+		cls->C = C;
+		for (i = 0; i < C - 1; i++)
+			cls->values[i] = st->num_handle == NUM_LOCAL ? limit :
+				attr->ptr[i];
+		cls->values[i] = 0;
+		for (i = 0; i < C; i++)
+			cls->cls[i] = sizes[i] ?
+				branch_node(st, counts + i * K, next,
+						&route[i]) :
+				get_leaf(0, major);
+		goto end;
+	}
+
+	/* empty values share a single default branch, the last one */
+	for (i = 0; i < C; i++) {
+		SKIPIF(sizes[i] == 0);
+		cls->values[cls->C] = i;
+		cls->cls[cls->C++] = branch_node(st, counts + i * K, next,
+				&route[i]);
+	}
+	if (cls->C < C) {
+		cls->values[cls->C] = CLS_ANY;
+		cls->cls[cls->C++] = get_leaf(0, major);
+	}
+
+end:
+	free(sizes);
+	free(classes);
+}
+
+struct classifier *branch_node(struct learn_state *st, const int *classes,
+		struct learn_level *next, int *route)
+{
+	struct classifier *cls;
+	int k, K, single, count;
+
+	K = st->descr->K;
+	for (k = 0, count = 0, single = -1; k < K; k++) {
+		SKIPIF(classes[k] == 0);
+		single = count ? -1 : k;
+		count += classes[k];
 	}
 
 	/* single class */
-	if (kc) {
-		struct classifier *newcls = calloc(1, sizeof(*newcls));
-		newcls->tag = last_tag;
-		newcls->id = cc;
-		newcls->C = 0;
-		return newcls;
+	if (single != -1)
+		return get_leaf(0, single);
+
+	cls = get_leaf(0, -1);
+	if (next->count == next->size) {
+		next->size = next->size ? 2 * next->size : 16;
+		next->nodes = realloc(next->nodes, next->size *
+				sizeof(next->nodes[0]));
+		next->classes = realloc(next->classes, next->size * K *
+				sizeof(next->classes[0]));
 	}
-	return id3_learn(descr, lset, last_tag);
+	next->nodes[next->count] = cls;
+	memcpy(next->classes + next->count * K, classes,
+			K * sizeof(classes[0]));
+	*route = next->count++;
+	return cls;
+}
+
+int number_tags(struct classifier *cls, int tag)
+{
+	int i;
+
+	cls->tag = tag++;
+	for (i = 0; i < cls->C; i++)
+		tag = number_tags(cls->cls[i], tag);
+	return tag;
 }
 
-struct classifier *build_discrete_classifier(const struct description *descr,
-		const struct example_set *lset, struct classifier *cls,
-		int index)
+struct classifier *id3_learn_oblivious(struct learn_state *st)
 {
-	int i, cc, kc;
+	const struct description *descr = st->descr;
+	const struct example_set *lset = st->lset;
+	int i, j, f, b, c, k, C, K, F, size, ibest, depth, *counts, *best,
+	    *tmp;
+	struct classifier *root, **level;
+	double iad, exp, gain, gbest;
+
+	K = descr->K;
+	for (i = 0, size = 0; i < descr->M; i++)
+		if (size < split_branches(descr->attribs[i]))
+			size = split_branches(descr->attribs[i]);
+	st->filter = calloc(lset->N, sizeof(st->filter[0]));
+	st->last_tag = 0;
+	/* each node of a level has at least one example */
+	level = calloc(lset->N, sizeof(level[0]));
+	counts = NULL;
+	best = NULL;
+
+	root = get_leaf(0, -1);
+	level[0] = root;
+	F = 1;
+	for (i = 0; i < lset->N; i++)
+		if (WEIGHT(st, i) == 0)
+			st->filter[i] = -1;
+
+	for (depth = 0; F && (!st->max_depth || depth < st->max_depth);
+			depth++) {
+		counts = realloc(counts, F * size * K * sizeof(counts[0]));
+		best = realloc(best, F * size * K * sizeof(best[0]));
+		/* the information of the level is that of its branches */
+		memset(best, 0, F * K * sizeof(best[0]));
+		for (i = 0, c = 0; i < lset->N; i++) {
+			SKIPIF(st->filter[i] == -1);
+			best[st->filter[i] * K + lset->examples[i]->class_id] +=
+				WEIGHT(st, i);
+			c += WEIGHT(st, i);
+		}
+		for (f = 0, iad = 0; f < F; f++) {
+			for (k = 0, j = 0; k < K; k++)
+				j += best[f * K + k];
+			iad += DIV(j, c) * id3_I_counts(K, best + f * K, j);
+		}
+
+		gbest = 0.0l;
+		ibest = -1;
+		for (i = 0; i < descr->M; i++) {
+			C = split_branches(descr->attribs[i]);
+			memset(counts, 0, F * C * K * sizeof(counts[0]));
+			for (j = 0; j < lset->N; j++) {
+				SKIPIF(st->filter[j] == -1);
+				b = branch_index(descr->attribs[i],
+						lset->examples[j]->attr_ids[i]);
+				counts[(st->filter[j] * C + b) * K +
+					lset->examples[j]->class_id] +=
+					WEIGHT(st, j);
+			}
+			for (f = 0, exp = 0; f < F * C; f++) {
+				for (k = 0, j = 0; k < K; k++)
+					j += counts[f * K + k];
+				SKIPIF(j == 0);
+				exp += DIV(j, c) *
+					id3_I_counts(K, counts + f * K, j);
+			}
+			gain = iad - exp;
+			if (gbest < gain && gain > EPS) {
+				gbest = gain;
+				ibest = i;
+				tmp = best;
+				best = counts;
+				counts = tmp;
+			}
+		}
+		if (ibest == -1)
+			break;
+		F = split_level(st, level, F, ibest, best);
+	}
 
-	kc = 1;
-	cc = -1;
-	last_tag++;
+	/* the nodes left give their majority class */
+	best = realloc(best, (F + 1) * K * sizeof(best[0]));
+	memset(best, 0, F * K * sizeof(best[0]));
 	for (i = 0; i < lset->N; i++) {
-		SKIPIF(lset->examples[i]->filter != cls->tag);
-		SKIPIF(lset->examples[i]->attr_ids[cls->id]
-				!= cls->values[index]);
-		if (lset->examples[i]->class_id != cc) {
-			if (cc != -1)
-				kc = 0;
+		SKIPIF(st->filter[i] == -1);
+		best[st->filter[i] * K + lset->examples[i]->class_id] +=
+			WEIGHT(st, i);
+	}
+	for (f = 0; f < F; f++)
+		level[f]->id = majority_class(K, best + f * K);
+
+	free(counts);
+	free(best);
+	free(level);
+	st->filter = free_and_set_NULL(st->filter);
+	return root;
+}
+
+int split_level(struct learn_state *st, struct classifier **level,
+		int F, int id, const int *counts)
+{
+	const struct description *descr = st->descr;
+	const struct attribute *attr = descr->attribs[id];
+	int i, f, b, k, C, K, NF, size, single, *next, *classes;
+	struct classifier *cls, **nodes;
+
+	K = descr->K;
+	C = split_branches(attr);
+	next = calloc(F * C, sizeof(next[0]));
+	classes = calloc(K, sizeof(classes[0]));
+
+	for (f = 0, NF = 0; f < F; f++) {
+		cls = level[f];
+		memset(classes, 0, K * sizeof(classes[0]));
+		for (b = 0; b < C; b++)
+			for (k = 0; k < K; k++)
+				classes[k] += counts[(f * C + b) * K + k];
+		for (k = 0, single = 0; k < K; k++)
+			INCRIF(classes[k], single);
+		for (b = 0; b < C; b++)
+			next[f * C + b] = -1;
+		if (single == 1) {
+			cls->id = majority_class(K, classes);
+			continue;
+		}
+
+		cls->id = id;
+		cls->C = C;
+		cls->values = calloc(C, sizeof(cls->values[0]));
+		cls->cls = calloc(C, sizeof(cls->cls[0]));
+		for (b = 0; b < C; b++) {
+			if (attr->type == NUMERIC)
+				cls->values[b] = b < C - 1 ? attr->ptr[b] : 0;
 			else
-				cc = lset->examples[i]->class_id;
+				cls->values[b] = b;
+			cls->cls[b] = get_leaf(++st->last_tag, -1);
+			for (k = 0, size = 0; k < K; k++)
+				size += counts[(f * C + b) * K + k];
+			/* empty branches give the majority class of the node */
+			if (size == 0)
+				cls->cls[b]->id = majority_class(K, classes);
+			else
+				next[f * C + b] = NF++;
 		}
-		lset->examples[i]->filter = last_tag;
 	}
 
-	/* single class */
-	if (kc) {
-		struct classifier *newcls = calloc(1, sizeof(*newcls));
-		newcls->tag = last_tag;
-		newcls->id = cc;
-		newcls->C = 0;
-		return newcls;
+	/* the nodes of the new level, in the order of their indexes */
+	nodes = calloc(NF + 1, sizeof(nodes[0]));
+	for (f = 0; f < F; f++)
+		for (b = 0; b < level[f]->C; b++)
+			if (next[f * C + b] != -1)
+				nodes[next[f * C + b]] = level[f]->cls[b];
+	memcpy(level, nodes, NF * sizeof(level[0]));
+	free(nodes);
+	for (i = 0; i < st->lset->N; i++) {
+		SKIPIF(st->filter[i] == -1);
+		b = branch_index(attr, st->lset->examples[i]->attr_ids[id]);
+		st->filter[i] = next[st->filter[i] * C + b];
 	}
-	return id3_learn(descr, lset, last_tag);
+
+	free(next);
+	free(classes);
+	return NF;
 }
 
-struct classifier *build_classifier(const struct description *descr,
-		const struct example_set *lset, struct classifier *cls,
-		int index)
+int majority_class(int K, const int *classes)
 {
-	if (descr->attribs[cls->id]->type == NUMERIC)
-		return build_numeric_classifier(descr, lset, cls, index);
-	return build_discrete_classifier(descr, lset, cls, index);
+	int k, major;
+
+	for (k = 1, major = 0; k < K; k++)
+		if (classes[k] > classes[major])
+			major = k;
+	return major;
 }
 
-struct classifier *split_on(const struct description *descr,
-		const struct example_set *lset, int tag, int id)
+int branch_index(const struct attribute *attr, int v)
 {
-	struct classifier *cls;
 	int i;
 
-	cls = calloc(1, sizeof(*cls));
-	cls->tag = tag;
-	cls->id = id;
-	cls->C = descr->attribs[id]->C;
-	INCRIF(descr->attribs[id]->type == NUMERIC, cls->C);
-	cls->values = calloc(cls->C, sizeof(cls->values[0]));
-	cls->cls = calloc(cls->C, sizeof(cls->cls[0]));
-
-	if (descr->attribs[id]->type == NUMERIC) {
-		for (i = 0; i < cls->C - 1; i++)
-			cls->values[i] = descr->attribs[id]->ptr[i];
-		cls->values[i] = 0;
-	} else
-		for (i = 0; i < cls->C; i++)
-			cls->values[i] = i;
-
-	for (i = 0; i < cls->C; i++)
-		cls->cls[i] = build_classifier(descr, lset, cls, i);
-
-	return cls;
+	if (attr->type != NUMERIC)
+		return v;
+	for (i = 0; i < attr->C; i++)
+		if (v < attr->ptr[i])
+			return i;
+	return attr->C;
 }
 
-struct classifier *get_default(int tag)
+struct classifier *get_leaf(int tag, int id)
 {
 	struct classifier *cls;
 
 	cls = calloc(1, sizeof(*cls));
 	cls->tag = tag;
-	cls->id = -1;
+	cls->id = id;
 	cls->C = 0;
 	return cls;
 }
@@ -506,7 +1228,7 @@ void id3_treat_missing(const struct description *descr,
 {
 	int i, index;
 
-	for (i = 0; i < MISS_COUNT; i++) {
+	for (i = 0; i < lset->missing_count; i++) {
 		index = lset->missing[i];
 		if (descr->attribs[index]->type == NUMERIC)
 			switch (missing_handle) {
@@ -532,32 +1254,29 @@ void id3_treat_missing(const struct description *descr,
 	}
 }
 
-void id3_build_index(const struct description *descr,
-		const struct example_set *lset)
+void id3_attr_index(const struct description *descr,
+		const struct example_set *lset, int index)
 {
-	int i, j, k, ii, jj;
-
-	for (i = 0; i < descr->M; i++) {
-		SKIPIF(descr->attribs[i]->type != NUMERIC);
-		descr->attribs[i]->C = lset->N;
-		descr->attribs[i]->ptr = calloc(lset->N,
-				sizeof(descr->attribs[i]->ptr));
-
-		for (j = 0; j < lset->N; j++)
-			descr->attribs[i]->ptr[j] = j;
-
-		/* sorting in place in O(N^2) */
-		for (j = 0; j < lset->N; j++)
-			for (k = j + 1; k < lset->N; k++) {
-				ii = descr->attribs[i]->ptr[j];
-				jj = descr->attribs[i]->ptr[k];
-				if (lset->examples[ii]->attr_ids[i] >
-					lset->examples[jj]->attr_ids[i]) {
-					descr->attribs[i]->ptr[k] = ii;
-					descr->attribs[i]->ptr[j] = jj;
-				}
+	struct attribute *attr = descr->attribs[index];
+	int j, k, ii, jj;
+
+	attr->C = lset->N;
+	attr->ptr = calloc(lset->N, sizeof(attr->ptr[0]));
+
+	for (j = 0; j < lset->N; j++)
+		attr->ptr[j] = j;
+
+	/* sorting in place in O(N^2) */
+	for (j = 0; j < lset->N; j++)
+		for (k = j + 1; k < lset->N; k++) {
+			ii = attr->ptr[j];
+			jj = attr->ptr[k];
+			if (lset->examples[ii]->attr_ids[index] >
+				lset->examples[jj]->attr_ids[index]) {
+				attr->ptr[k] = ii;
+				attr->ptr[j] = jj;
 			}
-	}
+		}
 }
 
 double split_e(const struct description *descr,
@@ -595,16 +1314,17 @@ double split_e(const struct description *descr,
 }
 
 double id3_get_split_value(const struct description *descr,
-		const struct example_set *lset, int index)
+		const struct example_set *lset, int index, int *tags)
 {
 	double p = 0;
 	int C = descr->attribs[index]->C, N = lset->N, tag, *classes, i, cc,
 	    sc, j, aid, k;
 
 	classes = calloc(descr->K, sizeof(classes[0]));
+	memset(tags, 0, N * sizeof(tags[0]));
 	for (i = 0, tag = 1; i < C; i++) {
 		for (j = 0, cc = 0, sc = 0; j < N; j++) {
-			SKIPIF(lset->examples[j]->filter != 0);
+			SKIPIF(tags[j] != 0);
 			aid = lset->examples[j]->attr_ids[index];
 			SKIPIF(aid >= descr->attribs[index]->ptr[i]);
 			sc++;
@@ -613,14 +1333,14 @@ double id3_get_split_value(const struct description *descr,
 					break;
 			if (k == cc)
 				classes[cc++] = lset->examples[j]->class_id;
-			lset->examples[j]->filter = tag;
+			tags[j] = tag;
 		}
-		p += id3_I_decision_tree(descr, lset, tag,
-				id3_filtered_count(lset, tag)) * (cc + sc);
+		p += id3_I_decision_tree(descr, lset, tags, tag,
+				id3_filtered_count(tags, N, tag)) * (cc + sc);
 		tag++;
 	}
 	for (j = 0, cc = 0, sc = 0; j < N; j++) {
-		SKIPIF(lset->examples[j]->filter != 0);
+		SKIPIF(tags[j] != 0);
 		aid = lset->examples[j]->attr_ids[index];
 		sc++;
 		for (k = 0; k < cc; k++)
@@ -628,11 +1348,10 @@ double id3_get_split_value(const struct description *descr,
 				break;
 		if (k == cc)
 			classes[cc++] = lset->examples[j]->class_id;
-		lset->examples[j]->filter = tag;
+		tags[j] = tag;
 	}
-	p += id3_I_decision_tree(descr, lset, tag,
-			id3_filtered_count(lset, tag)) * (cc + sc);
-	clear_filter_info(lset);
+	p += id3_I_decision_tree(descr, lset, tags, tag,
+			id3_filtered_count(tags, N, tag)) * (cc + sc);
 	free_and_set_NULL(classes);
 	return p;
 }
@@ -642,10 +1361,11 @@ void id3_attr_full_discr(const struct description *descr,
 		int index, int *candidates, double *entropies,
 		int ccount, int imin)
 {
-	int i, j;
+	int i, j, *tags;
 	double p1, p2, delta;
 
-	p1 = id3_get_split_value(descr, lset, index);
+	tags = calloc(lset->N, sizeof(tags[0]));
+	p1 = id3_get_split_value(descr, lset, index, tags);
 	do {
 		ccount--;
 		for (i = imin; i < ccount; i++) {
@@ -661,29 +1381,35 @@ void id3_attr_full_discr(const struct description *descr,
 				descr->attribs[index]->ptr[j-1];
 		descr->attribs[index]->ptr[i] = candidates[imin];
 		descr->attribs[index]->C++;
-		p2 = id3_get_split_value(descr, lset, index);
+		p2 = id3_get_split_value(descr, lset, index, tags);
 		delta = p2 - p1;
 		p1 = p2;
 	} while (delta > 0 && ccount > 2);
+	free(tags);
 }
 
 int compute_candidates(const struct description *descr,
 		const struct example_set *lset, int index, int *candidates)
 {
-	int C, i, cclass, ix, cid, aid, ccount;
+	const long long *ptr = descr->attribs[index]->ptr;
+	int C, i, j, aid, cclass, pclass, ccount;
 
 	C = descr->attribs[index]->C;
-	cclass = lset->examples[descr->attribs[index]->ptr[0]]->class_id;
 	ccount = 0;
-	for (i = 0; i < C; i++) {
-		ix = descr->attribs[index]->ptr[i];
-		cid = lset->examples[ix]->class_id;
-		aid = lset->examples[ix]->attr_ids[index];
-		SKIPIF(ccount && aid == candidates[ccount - 1]);
-		if (cid != cclass) {
-			cclass = cid;
-			candidates[ccount++] = aid;
+	pclass = CLS_MIXED;
+	for (i = 0; i < C; i = j) {
+		/* the class of the group of examples with this value */
+		aid = lset->examples[ptr[i]]->attr_ids[index];
+		cclass = lset->examples[ptr[i]]->class_id;
+		for (j = i + 1; j < C; j++) {
+			if (lset->examples[ptr[j]]->attr_ids[index] != aid)
+				break;
+			if (lset->examples[ptr[j]]->class_id != cclass)
+				cclass = CLS_MIXED;
 		}
+		if (i && (cclass == CLS_MIXED || cclass != pclass))
+			candidates[ccount++] = aid;
+		pclass = cclass;
 	}
 	return ccount;
 }
@@ -697,6 +1423,12 @@ void id3_attr_discr(const struct description *descr,
 
 	candidates = calloc(lset->N, sizeof(candidates[0]));
 	ccount = compute_candidates(descr, lset, index, candidates);
+	entropies = NULL;
+
+	/* no cut point (e.g. a single value): one interval */
+	descr->attribs[index]->C = 0;
+	if (ccount == 0)
+		goto end;
 
 	entropies = calloc(ccount, sizeof(entropies[0]));
 	for (i = 0; i < ccount; i++)
@@ -706,7 +1438,7 @@ void id3_attr_discr(const struct description *descr,
 
 	descr->attribs[index]->ptr[0] = candidates[imin];
 	descr->attribs[index]->C = 1;
-	if (num_handle == NUM_DIV || lset->N == 1)
+	if (num_handle == NUM_DIV || ccount == 1)
 		goto end;
 
 	id3_attr_full_discr(descr, lset, index, candidates,
@@ -718,13 +1450,24 @@ end:
 }
 
 void id3_discretization(const struct description *descr,
-		const struct example_set *lset, int num_handle)
+		const struct example_set *lset, int num_handle, int jobs)
 {
-	int i;
+	struct discr_work work;
 
-	for (i = 0; i < descr->M; i++) {
-		SKIPIF(descr->attribs[i]->type != NUMERIC);
-		id3_attr_discr(descr, lset, i, num_handle);
-	}
+	work.descr = descr;
+	work.lset = lset;
+	work.num_handle = num_handle;
+	run_tasks(jobs, descr->M, id3_discr_task, &work);
 }
 
+void id3_discr_task(void *arg, int index)
+{
+	struct discr_work *work = arg;
+
+	if (work->descr->attribs[index]->type != NUMERIC)
+		return;
+	id3_attr_index(work->descr, work->lset, index);
+	if (work->num_handle != NUM_LOCAL)
+		id3_attr_discr(work->descr, work->lset, index,
+				work->num_handle);
+}
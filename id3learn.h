@@ -19,42 +19,166 @@
 #ifndef _ID3LEARN_H
 #define _ID3LEARN_H
 
+#include "globals.h"
+
+/**
+ * @brief State of one learning process.
+ *
+ * Passed down the recursion instead of being kept in static variables, so
+ * that several learning processes can run at the same time.
+ */
+struct learn_state {
+	/** The description of the problem */
+	const struct description *descr;
+	/** The learning set */
+	const struct example_set *lset;
+	/** Node of the level being learned reached by each example of the
+	 * learning set (-1 if left out or if it reached a leaf)
+	 */
+	int *filter;
+	/** Count of copies of each example in the sample learned from (NULL
+	 * if each example is taken once)
+	 */
+	const int *weight;
+	/** How numeric arguments are handled */
+	int num_handle;
+	/** Count of attributes tested at each node (0 to test all of them) */
+	int features;
+	/** State of the generator choosing the attributes tested */
+	unsigned seed;
+	/** Depth at which the nodes become leaves giving their majority
+	 * class (0 for no limit)
+	 */
+	int max_depth;
+	/** Last tag given to a node */
+	int last_tag;
+};
+
+/**
+ * @brief Options of the learning process.
+ */
+struct learn_options {
+	/** How to handle numeric arguments */
+	int num_handle;
+	/** How to handle missing arguments */
+	int missing_handle;
+	/** 1 if identical subtrees are shared in the output */
+	int dag;
+	/** 1 if an oblivious tree is learned */
+	int oblivious;
+	/** How to prune the learned tree */
+	int prune;
+	/** Maximum depth of the tree (0 for no limit) */
+	int max_depth;
+	/** Count of numeric attributes prepared at the same time */
+	int jobs;
+	/** Holdout set file (only for PRUNE_REP) */
+	FILE *holdout;
+};
+
 /**
  * @brief Bootstraps the learning phase by reading data from the input files.
  *
  * It is simply a wrapper function around more useful functions, defined in
  * this file.
  *
- * @param num_handle How to handle numeric arguments.
- * @param missing_handle How to handle missing arguments.
+ * @param opts Learning options.
  * @param attr_file Filename for the attribute description file.
  * @param learn_file Filename for the example set file.
  * @param id3_file Filename used to output the classifier in a raw form.
  * @return The exit code for the learning process.
  */
-int id3_learn_bootstrap_file(int num_handle, int missing_handle,
+int id3_learn_bootstrap_file(const struct learn_options *opts,
 		FILE *attr_file, FILE *learn_file, FILE *id3_file);
 
 /**
- * @brief Builds a classifier obtained after splitting the example set
- * according to one attribute.
+ * @brief Learns the classifier for an example set already in memory.
+ *
+ * Fills in the missing values and discretizes the numeric attributes (the
+ * description is updated with the discretization limits) before building
+ * the tree.
+ *
+ * @param descr The description of the problem.
+ * @param lset The learning set.
+ * @param num_handle How to handle numeric arguments.
+ * @param missing_handle How to handle missing arguments.
+ * @return Classifier
+ */
+struct classifier *id3_learn_set(const struct description *descr,
+		struct example_set *lset, int num_handle, int missing_handle);
+
+/**
+ * @brief Prepares an example set for learning.
  *
- * See the struct classifier documentation. This function is recursive too (it
- * calls id3_learn and is called from it). Together they build the entire id3
- * tree.
+ * Fills in the missing values and discretizes the numeric attributes (the
+ * description is updated with the discretization limits; with NUM_LOCAL the
+ * examples are only sorted by each numeric attribute). Afterwards, the
+ * set and the description are only read while learning, thus they can be
+ * shared by several learning processes. The numeric attributes are
+ * independent, thus up to jobs of them are prepared at the same time.
  *
  * @param descr The description of the problem.
  * @param lset The learning set.
- * @param tag Tag used to filter the learning set.
- * @param id Id of attribute being split on
+ * @param num_handle How to handle numeric arguments.
+ * @param missing_handle How to handle missing arguments.
+ * @param jobs Count of threads used
+ */
+void id3_prepare_set(const struct description *descr,
+		struct example_set *lset, int num_handle, int missing_handle,
+		int jobs);
+
+/**
+ * @brief Learns the classifier for a sample of a prepared example set.
+ *
+ * The tree is built one level at a time: a single pass over the examples
+ * counts, for every node of the level and every attribute, the examples of
+ * each class taking each branch. The tests of all the nodes of the level are
+ * chosen from these counts and the examples are moved to the nodes of the
+ * next level. Thus the examples are read once for each level of the tree,
+ * not once for each node.
+ *
+ * With NUM_LOCAL, the numeric attributes are not discretized: each node
+ * splits a numeric attribute in two at the threshold giving the lowest
+ * entropy for its own examples. The examples are sorted by each numeric
+ * attribute only once; the sorted lists are split among the nodes of each
+ * level, keeping their order, thus the examples of each node are found in
+ * order without sorting again.
+ *
+ * The descr, lset, weight, num_handle, features, seed and max_depth members
+ * of the state must be set. An example is counted weight[i] times and, if
+ * features is not 0, only that many attributes chosen at random are tested
+ * at each node (the others are tested only if none of them splits the
+ * examples). If max_depth is not 0, the nodes at that depth (the root being
+ * at depth 0) are not split and give their majority class.
+ *
+ * @param st State of the learning process.
  * @return Classifier
  */
-struct classifier *split_on(const struct description *descr,
-		const struct example_set *lset, int tag, int id);
+struct classifier *id3_learn_tree(struct learn_state *st);
+
+/**
+ * @brief Learns an oblivious classifier for a sample of a prepared example
+ * set.
+ *
+ * The tree is built level by level: all the nodes of a level test the same
+ * attribute, the one giving the greatest gain over the whole level. Nodes
+ * with a single class become leaves, the other ones are split until no
+ * attribute gives any gain. The last nodes and the empty branches give the
+ * majority class. The state is used as for id3_learn_tree (features is
+ * ignored and num_handle can't be NUM_LOCAL), max_depth limiting the count
+ * of levels split.
+ *
+ * @param st State of the learning process.
+ * @return Classifier
+ */
+struct classifier *id3_learn_oblivious(struct learn_state *st);
 
 /**
  * @brief Discretization of a single attribute.
  *
+ * Without any cut point worth trying the attribute keeps a single interval
+ * (C is 0) and is never tested by the tree.
+ *
  * @param descr The description of the problem
  * @param lset The learning set
  * @param index Index of attribute
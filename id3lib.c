@@ -0,0 +1,272 @@
+/*!
+ * @file id3lib.c
+ * @brief Library interface of the id3 classifier.
+ * @author Mihai Maruseac (mihai@rosedu.org)
+ *
+ * @section DESCRIPTION
+ * IAUT1: ID3: Library interface of the id3 classifier.
+ *
+ * Contains the functions used to embed the classifier in other programs:
+ * learning from data already in memory, loading a classifier from a buffer
+ * and classifying examples.
+ *
+ * @section QUOTE
+ * The best way to predict the future is to invent it. (Alan Kay)
+ *
+ * @bug No known bugs.
+ */
+
+#include "globals.h"
+#include "id3flat.h"
+#include "id3learn.h"
+#include "id3lib.h"
+
+#if ID3_MISS_COUNT != MISS_COUNT
+#error "ID3_MISS_COUNT must match MISS_COUNT"
+#endif
+
+/**
+ * @brief Structure representing a classifier.
+ */
+struct id3_model {
+	/** Description */
+	struct description *descr;
+	/** The classifier */
+	struct classifier *cls;
+	/** Flattened classifier, used for single examples */
+	struct flat_tree *tree;
+	/** Binary classifier, used for batches */
+	struct batch_tree *batch;
+};
+
+/**
+ * @brief Builds the compiled forms of the classifier of a model.
+ *
+ * @param model The model (descr and cls are set)
+ * @return The model
+ */
+static struct id3_model *compile_model(struct id3_model *model);
+
+/**
+ * @brief Reads a description from a buffer.
+ *
+ * @param buf The buffer
+ * @param len Length of buf
+ * @return The description or NULL on error
+ */
+static struct description *read_description_buffer(const char *buf,
+		size_t len);
+
+/**
+ * @brief Maps a numeric handling of the library to the internal one.
+ *
+ * @param num_handle ID3_NUM_DIV, ID3_NUM_FULL or ID3_NUM_LOCAL
+ * @return NUM_DIV, NUM_FULL or NUM_LOCAL, 0 if num_handle is not valid
+ */
+static int lib_num_handle(int num_handle);
+
+/**
+ * @brief Maps a missing values handling of the library to the internal one.
+ *
+ * @param missing_handle ID3_MISS_MAJ or ID3_MISS_PRB
+ * @return MISS_MAJ or MISS_PRB, 0 if missing_handle is not valid
+ */
+static int lib_missing_handle(int missing_handle);
+
+/**
+ * @brief Builds the learning set from examples stored by columns.
+ *
+ * @param descr The description of the problem
+ * @param columns Values of the attributes (see id3_model_learn)
+ * @param classes Index of the class of each example
+ * @param N Count of examples
+ * @return The learning set or NULL on error
+ */
+static struct example_set *build_learning_set(const struct description *descr,
+		const int *const *columns, const int *classes, int N);
+
+struct id3_model *id3_model_learn(const char *descr_buf, size_t len,
+		const int *const *columns, const int *classes, int N,
+		int num_handle, int missing_handle)
+{
+	struct id3_model *model;
+	struct example_set *lset;
+
+	num_handle = lib_num_handle(num_handle);
+	CHECK(num_handle != 0, fail);
+	missing_handle = lib_missing_handle(missing_handle);
+	CHECK(missing_handle != 0, fail);
+	CHECK(N > 0, fail);
+
+	model = calloc(1, sizeof(*model));
+	model->descr = read_description_buffer(descr_buf, len);
+	CHECK(model->descr != NULL, nodescr);
+	lset = build_learning_set(model->descr, columns, classes, N);
+	CHECK(lset != NULL, nodescr);
+
+	model->cls = id3_learn_set(model->descr, lset, num_handle,
+			missing_handle);
+	free_example_set(lset);
+	free_and_set_NULL(lset);
+	return compile_model(model);
+
+nodescr:
+	id3_model_free(model);
+fail:
+	set_error(EINVAL);
+	return NULL;
+}
+
+struct id3_model *id3_model_load(const char *buf, size_t len)
+{
+	struct id3_model *model;
+	FILE *file;
+
+	file = fmemopen((void *)buf, len, "r");
+	CHECK(file != NULL, nofile);
+	model = calloc(1, sizeof(*model));
+	model->descr = read_description_file(file);
+	CHECK(model->descr != NULL, fail);
+	model->cls = read_classifier(file);
+	CHECK(model->cls != NULL, fail);
+	fclose(file);
+	return compile_model(model);
+
+fail:
+	id3_model_free(model);
+	fclose(file);
+	set_error(EINVAL);
+nofile:
+	return NULL;
+}
+
+void id3_model_write(const struct id3_model *model, FILE *file)
+{
+	write_id3_temp_file(model->descr, model->cls, file);
+}
+
+int id3_model_attributes(const struct id3_model *model)
+{
+	return model->descr->M;
+}
+
+int id3_model_parse(const struct id3_model *model, char *line, int *attr_ids)
+{
+	return parse_testing_line(line, model->descr, attr_ids);
+}
+
+int id3_model_classify(const struct id3_model *model, const int *attr_ids)
+{
+	return flat_classify(model->tree, attr_ids);
+}
+
+void id3_model_classify_batch(const struct id3_model *model, const int *rows,
+		int count, int *classes)
+{
+	batch_classify(model->batch, rows, count, classes);
+}
+
+const char *id3_model_class_name(const struct id3_model *model, int id)
+{
+	if (id < 0 || id >= model->descr->K)
+		return "unknown";
+	return model->descr->classes[id];
+}
+
+void id3_model_free(struct id3_model *model)
+{
+	if (model == NULL)
+		return;
+
+	if (model->descr) {
+		free_description(model->descr);
+		free_and_set_NULL(model->descr);
+	}
+	free_classifier(model->cls);
+	free_flat_tree(model->tree);
+	free_batch_tree(model->batch);
+	free_and_set_NULL(model);
+}
+
+struct id3_model *compile_model(struct id3_model *model)
+{
+	model->tree = flatten_classifier(model->descr, model->cls);
+	model->batch = batch_compile(model->descr, model->cls);
+	return model;
+}
+
+struct description *read_description_buffer(const char *buf, size_t len)
+{
+	struct description *descr;
+	FILE *file;
+
+	file = fmemopen((void *)buf, len, "r");
+	CHECK(file != NULL, fail);
+	descr = read_description_file(file);
+	fclose(file);
+	return descr;
+fail:
+	return NULL;
+}
+
+int lib_num_handle(int num_handle)
+{
+	switch (num_handle) {
+	case ID3_NUM_DIV:
+		return NUM_DIV;
+	case ID3_NUM_FULL:
+		return NUM_FULL;
+	case ID3_NUM_LOCAL:
+		return NUM_LOCAL;
+	default:
+		return 0;
+	}
+}
+
+int lib_missing_handle(int missing_handle)
+{
+	switch (missing_handle) {
+	case ID3_MISS_MAJ:
+		return MISS_MAJ;
+	case ID3_MISS_PRB:
+		return MISS_PRB;
+	default:
+		return 0;
+	}
+}
+
+struct example_set *build_learning_set(const struct description *descr,
+		const int *const *columns, const int *classes, int N)
+{
+	struct example_set *set;
+	struct example *ex;
+	int i, j, v, l;
+
+	set = calloc(1, sizeof(*set));
+	set->examples = calloc(N, sizeof(set->examples[0]));
+	for (i = 0; i < N; i++, set->N++) {
+		ex = calloc(1, sizeof(*ex));
+		set->examples[i] = ex;
+		ex->attr_ids = calloc(descr->M, sizeof(ex->attr_ids[0]));
+		CHECK(classes[i] >= 0 && classes[i] < descr->K, fail);
+		ex->class_id = classes[i];
+		for (j = 0; j < descr->M; j++) {
+			v = columns[j][i];
+			if (v == ID3_MISSING) {
+				l = record_missing(j, set);
+				CHECK(l != 0, fail);
+				ex->miss |= l;
+				continue;
+			}
+			CHECK(descr->attribs[j]->type == NUMERIC ||
+				(v >= 0 && v < descr->attribs[j]->C), fail);
+			ex->attr_ids[j] = v;
+		}
+	}
+	return set;
+
+fail:
+	set->N++;
+	free_example_set(set);
+	return free_and_set_NULL(set);
+}
@@ -0,0 +1,148 @@
+/*!
+ * @file id3lib.h
+ * @brief Library interface of the id3 classifier.
+ * @author Mihai Maruseac (mihai@rosedu.org)
+ *
+ * @section DESCRIPTION
+ * IAUT1: ID3: Library interface of the id3 classifier.
+ *
+ * Contains the functions used to embed the classifier in other programs:
+ * learning from data already in memory, loading a classifier from a buffer
+ * and classifying examples. Every function works on a model handle and no
+ * state is shared between handles, thus several models can be used at the
+ * same time. A model is read-only after it is built, so it can be used to
+ * classify from several threads.
+ *
+ * @section QUOTE
+ * The best way to predict the future is to invent it. (Alan Kay)
+ *
+ * @bug No known bugs.
+ */
+
+#ifndef _ID3LIB_H
+#define _ID3LIB_H
+
+#include <limits.h>
+#include <stdio.h>
+
+/**
+ * @brief Marks the functions exported by the shared library (the other
+ * symbols are hidden).
+ */
+#define ID3_API __attribute__((visibility("default")))
+
+#define ID3_MISSING INT_MIN /**< @brief Value marking a missing attribute */
+#define ID3_MISS_COUNT 2 /**< @brief Max attributes with missing values */
+
+#define ID3_NUM_DIV 1 /**< @brief Numeric attributes split in two */
+#define ID3_NUM_FULL 2 /**< @brief Numeric attributes split in intervals */
+#define ID3_NUM_LOCAL 3 /**< @brief Numeric split chosen at each node */
+
+#define ID3_MISS_MAJ 1 /**< @brief Missing values replaced by the majority */
+#define ID3_MISS_PRB 2 /**< @brief Missing values guessed with probabilities */
+
+/**
+ * @brief Handle of a classifier (opaque).
+ */
+struct id3_model;
+
+/**
+ * @brief Learns a classifier from examples stored by columns.
+ *
+ * The description has the same format as the attribute file of id3 l. The
+ * values of discrete attributes are indexes into the list of values from
+ * the description. Missing values are marked by ID3_MISSING (at most
+ * ID3_MISS_COUNT attributes can have missing values).
+ *
+ * @param descr_buf The description of the problem
+ * @param len Length of descr_buf
+ * @param columns Values of the attributes: columns[j][i] is the value of
+ * attribute j for example i
+ * @param classes Index of the class of each example
+ * @param N Count of examples
+ * @param num_handle How to handle numeric arguments (ID3_NUM_DIV,
+ * ID3_NUM_FULL or ID3_NUM_LOCAL)
+ * @param missing_handle How to handle missing arguments (ID3_MISS_MAJ or
+ * ID3_MISS_PRB)
+ * @return The model or NULL on error (errno is set)
+ */
+ID3_API struct id3_model *id3_model_learn(const char *descr_buf, size_t len,
+		const int *const *columns, const int *classes, int N,
+		int num_handle, int missing_handle);
+
+/**
+ * @brief Loads a classifier from a buffer holding the output of id3 l.
+ *
+ * @param buf The buffer
+ * @param len Length of buf
+ * @return The model or NULL on error (errno is set)
+ */
+ID3_API struct id3_model *id3_model_load(const char *buf, size_t len);
+
+/**
+ * @brief Writes the classifier in the format used by id3 l.
+ *
+ * @param model The model
+ * @param file File to write to.
+ */
+ID3_API void id3_model_write(const struct id3_model *model, FILE *file);
+
+/**
+ * @brief Returns the count of attributes of an example.
+ *
+ * @param model The model
+ * @return Count of attributes
+ */
+ID3_API int id3_model_attributes(const struct id3_model *model);
+
+/**
+ * @brief Parses one example given as a line of text (as in a testing file).
+ *
+ * @param model The model
+ * @param line The line (modified while parsing)
+ * @param attr_ids Output: values of the attributes
+ * @return 0 on success, -1 on error
+ */
+ID3_API int id3_model_parse(const struct id3_model *model, char *line,
+		int *attr_ids);
+
+/**
+ * @brief Classifies one example.
+ *
+ * @param model The model
+ * @param attr_ids Values of the attributes
+ * @return Id of class or -1 if the class is unknown.
+ */
+ID3_API int id3_model_classify(const struct id3_model *model,
+		const int *attr_ids);
+
+/**
+ * @brief Classifies several examples at once.
+ *
+ * @param model The model
+ * @param rows Values of the attributes, one example after another
+ * @param count Count of examples
+ * @param classes Output: id of class (or -1) for each example
+ */
+ID3_API void id3_model_classify_batch(const struct id3_model *model,
+		const int *rows, int count, int *classes);
+
+/**
+ * @brief Returns the name of a class.
+ *
+ * @param model The model
+ * @param id Id of class, as returned by the classification functions
+ * @return Name of class or "unknown"
+ */
+ID3_API const char *id3_model_class_name(const struct id3_model *model,
+		int id);
+
+/**
+ * @brief Frees a model.
+ *
+ * @param model The model
+ */
+ID3_API void id3_model_free(struct id3_model *model);
+
+#endif
+
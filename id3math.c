@@ -25,7 +25,18 @@
  */
 static double ZERO = 1e-5l;
 
-double log2(double x)
+/**
+ * @brief Computes the log2 of a value (0 for values close to 0).
+ *
+ * Not named log2, to not replace the one from libm in the programs using
+ * the library.
+ *
+ * @param x The value
+ * @return log2(x)
+ */
+static double log_2(double x);
+
+double log_2(double x)
 {
 	if (x < ZERO)
 		return 0;
@@ -38,6 +49,6 @@ double entropy(double p)
 		return 0;
 	if (p > 1)
 		return 0;
-	return -p * log2(p);
+	return -p * log_2(p);
 }
 
@@ -18,14 +18,6 @@
 #ifndef _ID3MATH_H
 #define _ID3MATH_H
 
-/**
- * @brief Computes the log2 of a value.
- *
- * @param x The value
- * @return log2(x)
- */
-double log2(double x);
-
 /**
  * @brief Computes the information entropy associated with a probability.
  *
@@ -0,0 +1,335 @@
+/*!
+ * @file id3prune.c
+ * @brief Pruning of an id3 classifier.
+ * @author Mihai Maruseac (mihai@rosedu.org)
+ *
+ * @section DESCRIPTION
+ * IAUT1: ID3: Pruning of an id3 classifier.
+ *
+ * Contains the functions used to replace subtrees of a learned classifier
+ * by leaves, when the subtrees are not expected to classify new examples
+ * better than the leaves.
+ *
+ * @section QUOTE
+ * Perfection is achieved, not when there is nothing more to add, but when
+ * there is nothing left to take away. (Antoine de Saint-Exupery)
+ *
+ * @bug No known bugs.
+ */
+
+#include <math.h>
+
+#include "globals.h"
+#include "id3prune.h"
+
+/**
+ * @brief Structure representing the pruning process.
+ */
+struct prune_state {
+	/** The description of the problem */
+	const struct description *descr;
+	/** Pruning method */
+	int method;
+};
+
+/**
+ * @brief Structure representing the examples reaching a node.
+ */
+struct prune_set {
+	/** Count of examples */
+	int N;
+	/** The examples */
+	const struct example **examples;
+};
+
+/**
+ * @brief Structure representing the errors made by a subtree.
+ */
+struct prune_errors {
+	/** Count of leaves */
+	int leaves;
+	/** Errors on the learning examples */
+	int learn;
+	/** Errors on the holdout examples */
+	int holdout;
+};
+
+/**
+ * @brief Prunes the subtree of one node.
+ *
+ * @param st State of the pruning process
+ * @param cls The node
+ * @param lset Learning examples reaching the node
+ * @param hset Holdout examples reaching the node
+ * @param err Output: errors made by the pruned subtree
+ * @return The pruned node
+ */
+static struct classifier *prune_node(const struct prune_state *st,
+		struct classifier *cls, const struct prune_set *lset,
+		const struct prune_set *hset, struct prune_errors *err);
+
+/**
+ * @brief Replaces a node by a leaf.
+ *
+ * @param cls The node (freed)
+ * @param id Id of class of the leaf
+ * @param lset Learning examples reaching the node
+ * @param hset Holdout examples reaching the node
+ * @param err Output: errors made by the leaf
+ * @return The leaf
+ */
+static struct classifier *make_leaf(struct classifier *cls, int id,
+		const struct prune_set *lset, const struct prune_set *hset,
+		struct prune_errors *err);
+
+/**
+ * @brief Computes the errors made by a leaf.
+ *
+ * @param id Id of class of the leaf
+ * @param lset Learning examples reaching the leaf
+ * @param hset Holdout examples reaching the leaf
+ * @param err Output: errors made by the leaf
+ */
+static void leaf_errors(int id, const struct prune_set *lset,
+		const struct prune_set *hset, struct prune_errors *err);
+
+/**
+ * @brief Returns the branch of a node taken by an example.
+ *
+ * @param descr The description of the problem
+ * @param cls The node
+ * @param ex The example
+ * @return Index of branch or -1 if there is none
+ */
+static int branch_of(const struct description *descr,
+		const struct classifier *cls, const struct example *ex);
+
+/**
+ * @brief Selects the examples taking one branch of a node.
+ *
+ * @param descr The description of the problem
+ * @param cls The node
+ * @param branch Index of branch
+ * @param set Examples reaching the node
+ * @param sub Output: examples taking the branch
+ */
+static void select_branch(const struct description *descr,
+		const struct classifier *cls, int branch,
+		const struct prune_set *set, struct prune_set *sub);
+
+/**
+ * @brief Counts the examples of a set not having a given class.
+ *
+ * @param set The examples
+ * @param id Id of class (-1 for unknown class, counting all examples)
+ * @return Count of errors
+ */
+static int count_errors(const struct prune_set *set, int id);
+
+/**
+ * @brief Returns the most frequent class of a set.
+ *
+ * @param K Count of classes
+ * @param set The examples
+ * @return Id of class or -1 if the set is empty
+ */
+static int majority_class(int K, const struct prune_set *set);
+
+/**
+ * @brief Returns the class of a node whose branches are all leaves giving
+ * the same class (branches with unknown class are ignored).
+ *
+ * @param cls The node
+ * @return Id of class or -1 if the branches give different classes
+ */
+static int common_class(const struct classifier *cls);
+
+/**
+ * @brief Builds a set from the examples of an example set.
+ *
+ * @param from The example set (may be NULL)
+ * @param set Output: the set
+ * @param missing 1 if examples with missing values are kept
+ */
+static void init_set(const struct example_set *from, struct prune_set *set,
+		int missing);
+
+struct classifier *id3_prune(const struct description *descr,
+		const struct example_set *lset,
+		const struct example_set *hset,
+		struct classifier *cls, int method)
+{
+	struct prune_set learn, holdout;
+	struct prune_errors err;
+	struct prune_state st;
+
+	st.descr = descr;
+	st.method = method;
+	init_set(lset, &learn, 1);
+	init_set(hset, &holdout, 0);
+	cls = prune_node(&st, cls, &learn, &holdout, &err);
+	free(learn.examples);
+	free(holdout.examples);
+	return cls;
+}
+
+void init_set(const struct example_set *from, struct prune_set *set,
+		int missing)
+{
+	int i;
+
+	set->N = 0;
+	set->examples = NULL;
+	if (from == NULL)
+		return;
+
+	set->examples = calloc(from->N, sizeof(set->examples[0]));
+	for (i = 0; i < from->N; i++) {
+		SKIPIF(!missing && from->examples[i]->miss);
+		set->examples[set->N++] = from->examples[i];
+	}
+}
+
+struct classifier *prune_node(const struct prune_state *st,
+		struct classifier *cls, const struct prune_set *lset,
+		const struct prune_set *hset, struct prune_errors *err)
+{
+	struct prune_set lsub, hsub;
+	struct prune_errors sub;
+	double e, se;
+	int i, id;
+
+	if (cls->C == 0) {
+		leaf_errors(cls->id, lset, hset, err);
+		return cls;
+	}
+
+	err->leaves = 0;
+	err->learn = 0;
+	err->holdout = 0;
+	for (i = 0; i < cls->C; i++) {
+		select_branch(st->descr, cls, i, lset, &lsub);
+		select_branch(st->descr, cls, i, hset, &hsub);
+		cls->cls[i] = prune_node(st, cls->cls[i], &lsub, &hsub, &sub);
+		free(lsub.examples);
+		free(hsub.examples);
+		err->leaves += sub.leaves;
+		err->learn += sub.learn;
+		err->holdout += sub.holdout;
+	}
+
+	id = common_class(cls);
+	if (id != -1)
+		return make_leaf(cls, id, lset, hset, err);
+
+	id = majority_class(st->descr->K, lset);
+	switch (st->method) {
+	case PRUNE_PES:
+		e = err->learn + 0.5 * err->leaves;
+		se = e < lset->N ? sqrt(e * (lset->N - e) / lset->N) : 0;
+		if (count_errors(lset, id) + 0.5 <= e + se)
+			return make_leaf(cls, id, lset, hset, err);
+		break;
+	case PRUNE_REP:
+		if (count_errors(hset, id) <= err->holdout)
+			return make_leaf(cls, id, lset, hset, err);
+		break;
+	}
+	return cls;
+}
+
+struct classifier *make_leaf(struct classifier *cls, int id,
+		const struct prune_set *lset, const struct prune_set *hset,
+		struct prune_errors *err)
+{
+	struct classifier *leaf;
+
+	leaf = calloc(1, sizeof(*leaf));
+	leaf->tag = cls->tag;
+	leaf->id = id;
+	leaf->C = 0;
+	free_classifier(cls);
+	leaf_errors(id, lset, hset, err);
+	return leaf;
+}
+
+void leaf_errors(int id, const struct prune_set *lset,
+		const struct prune_set *hset, struct prune_errors *err)
+{
+	err->leaves = 1;
+	err->learn = count_errors(lset, id);
+	err->holdout = count_errors(hset, id);
+}
+
+int branch_of(const struct description *descr,
+		const struct classifier *cls, const struct example *ex)
+{
+	int i, v;
+
+	v = ex->attr_ids[cls->id];
+	if (descr->attribs[cls->id]->type == NUMERIC) {
+		for (i = 0; i < cls->C - 1; i++)
+			if (v < cls->values[i])
+				return i;
+		return cls->C - 1;
+	}
+
+	for (i = 0; i < cls->C; i++)
+		if (cls->values[i] == v || cls->values[i] == CLS_ANY)
+			return i;
+	return -1;
+}
+
+void select_branch(const struct description *descr,
+		const struct classifier *cls, int branch,
+		const struct prune_set *set, struct prune_set *sub)
+{
+	int i;
+
+	sub->N = 0;
+	sub->examples = calloc(set->N, sizeof(sub->examples[0]));
+	for (i = 0; i < set->N; i++)
+		if (branch_of(descr, cls, set->examples[i]) == branch)
+			sub->examples[sub->N++] = set->examples[i];
+}
+
+int count_errors(const struct prune_set *set, int id)
+{
+	int i, n;
+
+	for (i = 0, n = 0; i < set->N; i++)
+		INCRIF(set->examples[i]->class_id != id, n);
+	return n;
+}
+
+int majority_class(int K, const struct prune_set *set)
+{
+	int i, best, *counts;
+
+	if (set->N == 0)
+		return -1;
+
+	counts = calloc(K, sizeof(counts[0]));
+	for (i = 0; i < set->N; i++)
+		counts[set->examples[i]->class_id]++;
+	for (i = 1, best = 0; i < K; i++)
+		if (counts[i] > counts[best])
+			best = i;
+	free(counts);
+	return best;
+}
+
+int common_class(const struct classifier *cls)
+{
+	int i, id;
+
+	for (i = 0, id = -1; i < cls->C; i++) {
+		if (cls->cls[i]->C != 0)
+			return -1;
+		SKIPIF(cls->cls[i]->id == -1);
+		if (id != -1 && cls->cls[i]->id != id)
+			return -1;
+		id = cls->cls[i]->id;
+	}
+	return id;
+}
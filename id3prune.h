@@ -0,0 +1,50 @@
+/*!
+ * @file id3prune.h
+ * @brief Pruning of an id3 classifier.
+ * @author Mihai Maruseac (mihai@rosedu.org)
+ *
+ * @section DESCRIPTION
+ * IAUT1: ID3: Pruning of an id3 classifier.
+ *
+ * Contains the functions used to replace subtrees of a learned classifier
+ * by leaves, when the subtrees are not expected to classify new examples
+ * better than the leaves.
+ *
+ * @section QUOTE
+ * Perfection is achieved, not when there is nothing more to add, but when
+ * there is nothing left to take away. (Antoine de Saint-Exupery)
+ *
+ * @bug No known bugs.
+ */
+
+#ifndef _ID3PRUNE_H
+#define _ID3PRUNE_H
+
+#include "globals.h"
+
+/**
+ * @brief Prunes a classifier.
+ *
+ * The tree is processed bottom-up. With every method, a node whose branches
+ * are all leaves giving the same class (or an unknown class) is replaced by
+ * a leaf giving that class. With PRUNE_PES, a node is replaced by a leaf
+ * giving the majority class of the learning examples reaching it if the
+ * errors of the leaf on the learning set, corrected by 1/2 per leaf, are
+ * within one standard error of those of the subtree. With PRUNE_REP, it is
+ * replaced if the leaf makes no more errors than the subtree on the holdout
+ * set (holdout examples with missing values are ignored).
+ *
+ * @param descr The description of the problem (after learning)
+ * @param lset The learning set (after learning)
+ * @param hset The holdout set (only for PRUNE_REP)
+ * @param cls The classifier (not shared)
+ * @param method Pruning method (PRUNE_COL, PRUNE_PES or PRUNE_REP)
+ * @return The pruned classifier
+ */
+struct classifier *id3_prune(const struct description *descr,
+		const struct example_set *lset,
+		const struct example_set *hset,
+		struct classifier *cls, int method);
+
+#endif
+
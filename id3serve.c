@@ -0,0 +1,555 @@
+/*!
+ * @file id3serve.c
+ * @brief Classification server.
+ * @author Mihai Maruseac (mihai@rosedu.org)
+ *
+ * @section DESCRIPTION
+ * IAUT1: ID3: Classification server.
+ *
+ * Contains the functions used to serve classification requests over a Unix
+ * domain socket, loading the classifier only once.
+ *
+ * @section QUOTE
+ * Computers are useless. They can only give you answers. (Pablo Picasso)
+ *
+ * @bug No known bugs.
+ */
+
+#define _GNU_SOURCE /* accept4 */
+
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "globals.h"
+#include "id3flat.h"
+#include "id3serve.h"
+
+/**
+ * @brief Structure representing a loaded classifier.
+ */
+struct serve_model {
+	/** Description */
+	struct description *descr;
+	/** Flattened classifier */
+	struct flat_tree *tree;
+	/** Scratch vector for the attribute values of one request */
+	int *attr_ids;
+};
+
+/**
+ * @brief Structure used to reload the classifier in the background.
+ *
+ * The loader thread publishes the new model in pending and wakes the event
+ * loop through the eventfd. The other fields are used only by the event
+ * loop.
+ */
+struct serve_reload {
+	/** File containing the classifier */
+	const char *id3_file;
+	/** Model loaded by the loader thread (NULL if loading failed) */
+	struct serve_model *pending;
+	/** Eventfd signalled when the loader thread is done */
+	int evfd;
+	/** Loader thread */
+	pthread_t thread;
+	/** Set while the loader thread is running */
+	int running;
+	/** Set if a reload was requested while loading */
+	int again;
+};
+
+/**
+ * @brief Structure representing a connected client.
+ *
+ * Requests are accumulated in the input buffer until a full line is
+ * received. Answers are accumulated in the output buffer until the socket
+ * accepts them.
+ */
+struct serve_conn {
+	/** Socket of the client */
+	int fd;
+	/** Set when the client closed its side of the connection */
+	int eof;
+	/** Input buffer */
+	char *in;
+	/** Bytes in the input buffer */
+	size_t inlen;
+	/** Size of the input buffer */
+	size_t insize;
+	/** Output buffer */
+	char *out;
+	/** Bytes in the output buffer */
+	size_t outlen;
+	/** Bytes of the output buffer already sent */
+	size_t outsent;
+	/** Size of the output buffer */
+	size_t outsize;
+};
+
+/**
+ * @brief Loads a classifier from a file.
+ *
+ * @param id3_file File containing the classifier
+ * @return The model or NULL on error
+ */
+static struct serve_model *load_model(const char *id3_file);
+
+/**
+ * @brief Frees a model.
+ *
+ * @param model The model
+ */
+static void free_model(struct serve_model *model);
+
+/**
+ * @brief Loader thread: loads the classifier and wakes the event loop.
+ *
+ * @param arg The struct serve_reload
+ * @return NULL
+ */
+static void *reload_model(void *arg);
+
+/**
+ * @brief Starts the loader thread (or delays the reload if it is already
+ * running).
+ *
+ * @param reload Reload state
+ */
+static void start_reload(struct serve_reload *reload);
+
+/**
+ * @brief Called by the event loop when the loader thread is done. Swaps in
+ * the new model, if one was loaded.
+ *
+ * @param reload Reload state
+ * @param model Pointer to the current model
+ * @return The old model, to be freed when no request uses it, or NULL
+ */
+static struct serve_model *finish_reload(struct serve_reload *reload,
+		struct serve_model **model);
+
+/**
+ * @brief Creates the listening socket.
+ *
+ * @param socket_path Path of the Unix domain socket
+ * @return The socket or -1 on error
+ */
+static int serve_listen(const char *socket_path);
+
+/**
+ * @brief Accepts all pending connections.
+ *
+ * @param efd The epoll instance
+ * @param lfd The listening socket
+ */
+static void serve_accept(int efd, int lfd);
+
+/**
+ * @brief Reads the requests of a client and answers the complete ones.
+ *
+ * @param model The model
+ * @param conn The client
+ * @return 0 if the connection is still usable, -1 otherwise
+ */
+static int serve_read(const struct serve_model *model,
+		struct serve_conn *conn);
+
+/**
+ * @brief Classifies one request line and appends the answer.
+ *
+ * @param model The model
+ * @param conn The client
+ * @param line The request (modified while parsing)
+ */
+static void serve_line(const struct serve_model *model,
+		struct serve_conn *conn, char *line);
+
+/**
+ * @brief Appends one answer line to the output buffer of a client.
+ *
+ * @param conn The client
+ * @param answer The answer, without the newline
+ */
+static void serve_answer(struct serve_conn *conn, const char *answer);
+
+/**
+ * @brief Sends as much as possible from the output buffer of a client.
+ *
+ * Watches the socket for writability if not everything was sent.
+ *
+ * @param efd The epoll instance
+ * @param conn The client
+ * @return 0 if the connection is still usable, -1 otherwise
+ */
+static int serve_flush(int efd, struct serve_conn *conn);
+
+/**
+ * @brief Closes a connection and frees the client.
+ *
+ * @param conn The client
+ */
+static void serve_close(struct serve_conn *conn);
+
+struct serve_model *load_model(const char *id3_file)
+{
+	struct serve_model *model;
+	struct classifier *cls;
+	FILE *id3;
+
+	id3 = fopen(id3_file, "r");
+	CHECK(id3 != NULL, noid3);
+	model = calloc(1, sizeof(*model));
+	model->descr = read_description_file(id3);
+	CHECK(model->descr != NULL, fail);
+	cls = read_classifier(id3);
+	CHECK(cls != NULL, fail);
+	model->tree = flatten_classifier(model->descr, cls);
+	model->attr_ids = calloc(model->descr->M, sizeof(model->attr_ids[0]));
+	free_classifier(cls);
+	fclose(id3);
+	return model;
+fail:
+	free_model(model);
+	fclose(id3);
+noid3:
+	return NULL;
+}
+
+void free_model(struct serve_model *model)
+{
+	if (model == NULL)
+		return;
+
+	if (model->descr) {
+		free_description(model->descr);
+		free_and_set_NULL(model->descr);
+	}
+	free_flat_tree(model->tree);
+	free_and_set_NULL(model->attr_ids);
+	free_and_set_NULL(model);
+}
+
+void *reload_model(void *arg)
+{
+	struct serve_reload *reload = arg;
+	uint64_t one = 1;
+
+	__atomic_store_n(&reload->pending, load_model(reload->id3_file),
+			__ATOMIC_RELEASE);
+	if (write(reload->evfd, &one, sizeof(one)) != sizeof(one))
+		perror("Cannot signal reload");
+	return NULL;
+}
+
+void start_reload(struct serve_reload *reload)
+{
+	if (reload->running) {
+		reload->again = 1;
+		return;
+	}
+
+	reload->again = 0;
+	reload->running = pthread_create(&reload->thread, NULL,
+			reload_model, reload) == 0;
+	if (!reload->running)
+		perror("Cannot start reload");
+}
+
+struct serve_model *finish_reload(struct serve_reload *reload,
+		struct serve_model **model)
+{
+	struct serve_model *old, *new;
+	uint64_t count;
+
+	if (read(reload->evfd, &count, sizeof(count)) != sizeof(count))
+		return NULL;
+	pthread_join(reload->thread, NULL);
+	reload->running = 0;
+
+	old = NULL;
+	new = __atomic_exchange_n(&reload->pending, NULL, __ATOMIC_ACQUIRE);
+	if (new) {
+		old = *model;
+		__atomic_store_n(model, new, __ATOMIC_RELEASE);
+	} else
+		fprintf(stderr, "Cannot reload %s, keeping old classifier\n",
+				reload->id3_file);
+
+	if (reload->again)
+		start_reload(reload);
+	return old;
+}
+
+int serve_listen(const char *socket_path)
+{
+	struct sockaddr_un addr;
+	int fd;
+
+	CHECK(strlen(socket_path) < sizeof(addr.sun_path), fail);
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, socket_path);
+
+	fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	CHECK(fd != -1, fail);
+	unlink(socket_path);
+	CHECK(bind(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0, nobind);
+	CHECK(listen(fd, SOMAXCONN) == 0, nobind);
+	return fd;
+nobind:
+	close(fd);
+fail:
+	return -1;
+}
+
+void serve_accept(int efd, int lfd)
+{
+	struct epoll_event ev;
+	struct serve_conn *conn;
+	int fd;
+
+	while ((fd = accept4(lfd, NULL, NULL,
+				SOCK_NONBLOCK | SOCK_CLOEXEC)) != -1) {
+		conn = calloc(1, sizeof(*conn));
+		conn->fd = fd;
+		ev.events = EPOLLIN;
+		ev.data.ptr = conn;
+		if (epoll_ctl(efd, EPOLL_CTL_ADD, fd, &ev) == -1)
+			serve_close(conn);
+	}
+}
+
+void serve_line(const struct serve_model *model,
+		struct serve_conn *conn, char *line)
+{
+	const char *answer;
+	int id;
+
+	answer = "error";
+	if (parse_testing_line(line, model->descr, model->attr_ids) == 0) {
+		id = flat_classify(model->tree, model->attr_ids);
+		answer = id != -1 ? model->descr->classes[id] : "unknown";
+	}
+	serve_answer(conn, answer);
+}
+
+void serve_answer(struct serve_conn *conn, const char *answer)
+{
+	size_t len;
+
+	len = strlen(answer);
+	if (conn->outlen + len + 1 > conn->outsize) {
+		conn->outsize = 2 * (conn->outlen + len + 1);
+		conn->out = realloc(conn->out, conn->outsize);
+	}
+	memcpy(conn->out + conn->outlen, answer, len);
+	conn->outlen += len;
+	conn->out[conn->outlen++] = '\n';
+}
+
+int serve_read(const struct serve_model *model, struct serve_conn *conn)
+{
+	char *line, *end;
+	ssize_t r;
+
+	while (1) {
+		if (conn->insize - conn->inlen < SERVE_READ) {
+			conn->insize = 2 * conn->insize + SERVE_READ;
+			conn->in = realloc(conn->in, conn->insize);
+		}
+		r = read(conn->fd, conn->in + conn->inlen,
+				conn->insize - conn->inlen - 1);
+		if (r == 0)
+			conn->eof = 1;
+		if (r <= 0)
+			break;
+		conn->inlen += r;
+		conn->in[conn->inlen] = '\0';
+
+		line = conn->in;
+		while ((end = memchr(line, '\n',
+				conn->inlen - (line - conn->in))) != NULL) {
+			if (end - line >= SERVE_LINE_MAX)
+				break;
+			*end = '\0';
+			serve_line(model, conn, line);
+			line = end + 1;
+		}
+		conn->inlen -= line - conn->in;
+		memmove(conn->in, line, conn->inlen);
+
+		/* refuse to buffer endless lines, close after the answer */
+		if (conn->inlen >= SERVE_LINE_MAX) {
+			serve_answer(conn, "error");
+			conn->inlen = 0;
+			conn->eof = 1;
+			break;
+		}
+	}
+
+	/* last request may not end with a newline */
+	if (conn->eof && conn->inlen) {
+		conn->in[conn->inlen] = '\0';
+		serve_line(model, conn, conn->in);
+		conn->inlen = 0;
+	}
+
+	if (r == -1 && errno != EAGAIN && errno != EWOULDBLOCK)
+		return -1;
+	return 0;
+}
+
+int serve_flush(int efd, struct serve_conn *conn)
+{
+	struct epoll_event ev;
+	ssize_t w;
+
+	while (conn->outsent < conn->outlen) {
+		w = send(conn->fd, conn->out + conn->outsent,
+				conn->outlen - conn->outsent, MSG_NOSIGNAL);
+		if (w == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			break;
+		CHECK(w != -1, fail);
+		conn->outsent += w;
+	}
+
+	if (conn->outsent == conn->outlen) {
+		conn->outsent = 0;
+		conn->outlen = 0;
+		CHECK(!conn->eof, fail);
+	}
+
+	ev.events = conn->outlen ? EPOLLOUT : EPOLLIN;
+	ev.data.ptr = conn;
+	CHECK(epoll_ctl(efd, EPOLL_CTL_MOD, conn->fd, &ev) == 0, fail);
+	return 0;
+fail:
+	return -1;
+}
+
+void serve_close(struct serve_conn *conn)
+{
+	close(conn->fd);
+	free_and_set_NULL(conn->in);
+	free_and_set_NULL(conn->out);
+	free_and_set_NULL(conn);
+}
+
+int id3_serve(const char *id3_file, const char *socket_path)
+{
+	struct epoll_event ev, events[SERVE_EVENTS];
+	struct serve_model *model, *retired;
+	struct signalfd_siginfo info;
+	struct serve_reload reload;
+	struct serve_conn *conn;
+	int efd, lfd, sfd, i, n, stop, err;
+	sigset_t mask;
+
+	efd = -1;
+	sfd = -1;
+	memset(&reload, 0, sizeof(reload));
+	reload.id3_file = id3_file;
+	reload.evfd = -1;
+	model = load_model(id3_file);
+	CHECK(model != NULL, nomodel);
+	lfd = serve_listen(socket_path);
+	CHECK(lfd != -1, fail);
+
+	/* blocked before starting any thread, thus in all threads */
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGINT);
+	sigaddset(&mask, SIGTERM);
+	sigaddset(&mask, SIGHUP);
+	sigprocmask(SIG_BLOCK, &mask, NULL);
+	sfd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+	CHECK(sfd != -1, fail);
+	reload.evfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	CHECK(reload.evfd != -1, fail);
+
+	efd = epoll_create1(EPOLL_CLOEXEC);
+	CHECK(efd != -1, fail);
+	/* the listening socket, signals and reloads have no client attached */
+	ev.events = EPOLLIN;
+	ev.data.ptr = &lfd;
+	CHECK(epoll_ctl(efd, EPOLL_CTL_ADD, lfd, &ev) == 0, fail);
+	ev.data.ptr = &sfd;
+	CHECK(epoll_ctl(efd, EPOLL_CTL_ADD, sfd, &ev) == 0, fail);
+	ev.data.ptr = &reload;
+	CHECK(epoll_ctl(efd, EPOLL_CTL_ADD, reload.evfd, &ev) == 0, fail);
+
+	for (stop = 0, retired = NULL; !stop; ) {
+		n = epoll_wait(efd, events, SERVE_EVENTS, -1);
+		if (n == -1 && errno == EINTR)
+			continue;
+		CHECK(n != -1, fail);
+
+		for (i = 0; i < n; i++) {
+			if (events[i].data.ptr == &lfd) {
+				serve_accept(efd, lfd);
+				continue;
+			}
+			if (events[i].data.ptr == &sfd) {
+				while (read(sfd, &info, sizeof(info)) ==
+						sizeof(info))
+					if (info.ssi_signo == SIGHUP)
+						start_reload(&reload);
+					else
+						stop = 1;
+				continue;
+			}
+			if (events[i].data.ptr == &reload) {
+				retired = finish_reload(&reload, &model);
+				continue;
+			}
+
+			conn = events[i].data.ptr;
+			if (events[i].events & EPOLLIN && serve_read(
+					__atomic_load_n(&model,
+						__ATOMIC_ACQUIRE), conn))
+				goto drop;
+			if (events[i].events & EPOLLERR)
+				goto drop;
+			if (events[i].events & EPOLLHUP &&
+					!(events[i].events & EPOLLIN))
+				goto drop;
+			if (serve_flush(efd, conn))
+				goto drop;
+			continue;
+drop:
+			serve_close(conn);
+		}
+
+		/* quiescent state: no request uses the old model anymore */
+		free_model(retired);
+		retired = NULL;
+	}
+
+	/* connections still open are closed by exit */
+	errno = 0;
+fail:
+	err = errno;
+	if (reload.running)
+		pthread_join(reload.thread, NULL);
+	free_model(reload.pending);
+	if (reload.evfd != -1)
+		close(reload.evfd);
+	if (efd != -1)
+		close(efd);
+	if (sfd != -1)
+		close(sfd);
+	if (lfd != -1) {
+		close(lfd);
+		unlink(socket_path);
+	}
+	free_model(model);
+	return err ? set_error(err) : 0;
+nomodel:
+	return set_error(EINVAL);
+}
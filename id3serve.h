@@ -0,0 +1,48 @@
+/*!
+ * @file id3serve.h
+ * @brief Classification server.
+ * @author Mihai Maruseac (mihai@rosedu.org)
+ *
+ * @section DESCRIPTION
+ * IAUT1: ID3: Classification server.
+ *
+ * Contains the functions used to serve classification requests over a Unix
+ * domain socket, loading the classifier only once.
+ *
+ * @section QUOTE
+ * Computers are useless. They can only give you answers. (Pablo Picasso)
+ *
+ * @bug No known bugs.
+ */
+
+#ifndef _ID3SERVE_H
+#define _ID3SERVE_H
+
+#define SERVE_EVENTS 64 /**< @brief Max events handled in one loop iteration */
+#define SERVE_READ 4096 /**< @brief Bytes read at once from a client */
+#define SERVE_LINE_MAX (64 * 1024) /**< @brief Longest accepted request */
+
+/**
+ * @brief Starts the classification server.
+ *
+ * The classifier is loaded once, then the server accepts connections on a
+ * Unix domain socket. Each client sends examples, one per line (the values
+ * of the attributes, as in a testing file) and receives the name of the
+ * class of each example on a line (error for invalid examples). All clients
+ * are handled by a single epoll event loop. The server stops on SIGINT or
+ * SIGTERM.
+ *
+ * On SIGHUP the classifier file is loaded again by a background thread,
+ * while the old classifier keeps answering requests. If the new file is
+ * valid, the event loop swaps the classifiers between two requests and frees
+ * the old one at the end of the loop iteration, when no request can use it
+ * anymore (as in RCU). Requests never wait for a lock.
+ *
+ * @param id3_file File containing the classifier
+ * @param socket_path Path of the Unix domain socket
+ * @return error status or 0
+ */
+int id3_serve(const char *id3_file, const char *socket_path);
+
+#endif
+
@@ -0,0 +1,303 @@
+/*!
+ * @file id3sweep.c
+ * @brief Comparing the learning options of the id3 classifier.
+ * @author Mihai Maruseac (mihai@rosedu.org)
+ *
+ * @section DESCRIPTION
+ * IAUT1: ID3: Comparing the learning options of the id3 classifier.
+ *
+ * Contains the functions used to learn one classifier for each combination
+ * of several learning options, reading the input only once, and to compare
+ * them on a holdout set.
+ *
+ * @section QUOTE
+ * In theory, there is no difference between theory and practice. But, in
+ * practice, there is. (Jan L. A. van de Snepscheut)
+ *
+ * @bug No known bugs.
+ */
+
+#include "globals.h"
+#include "id3flat.h"
+#include "id3learn.h"
+#include "id3prune.h"
+#include "id3sweep.h"
+
+/**
+ * @brief Names of the ways to handle numeric arguments (by NUM_*).
+ */
+static const char *num_names[] = {NULL, "div", "full", "loc"};
+
+/**
+ * @brief Names of the ways to handle missing arguments (by MISS_*).
+ */
+static const char *missing_names[] = {NULL, "maj", "prb"};
+
+/**
+ * @brief Names of the ways to prune the learned tree (by PRUNE_*).
+ */
+static const char *prune_names[] = {"none", "col", "pes", "rep"};
+
+/**
+ * @brief One combination of options and its results.
+ */
+struct sweep_run {
+	/** How to handle numeric arguments */
+	int num_handle;
+	/** How to handle missing arguments */
+	int missing_handle;
+	/** How to prune the learned tree */
+	int prune;
+	/** Maximum depth of the tree (0 for no limit) */
+	int max_depth;
+	/** File to write the classifier to */
+	FILE *file;
+	/** Count of nodes of the tree */
+	int nodes;
+	/** Count of leaves of the tree */
+	int leaves;
+	/** Count of holdout examples classified */
+	int count;
+	/** Count of holdout examples classified correctly */
+	int correct;
+};
+
+/**
+ * @brief Work shared by the threads learning the combinations.
+ */
+struct sweep_work {
+	/** The description of the problem (as read) */
+	const struct description *descr;
+	/** The learning set (as read) */
+	const struct example_set *lset;
+	/** The holdout set */
+	const struct example_set *hset;
+	/** The combinations */
+	struct sweep_run *runs;
+	/** Count of combinations */
+	int count;
+};
+
+/**
+ * @brief Builds the list of combinations of options.
+ *
+ * @param opts Options
+ * @param runs Output: the combinations (room for all of them)
+ * @return Count of combinations
+ */
+static int list_runs(const struct sweep_options *opts,
+		struct sweep_run *runs);
+
+/**
+ * @brief Task learning one combination (see run_tasks).
+ *
+ * @param arg The struct sweep_work
+ * @param index Index of combination
+ */
+static void sweep_task(void *arg, int index);
+
+/**
+ * @brief Learns, writes and tests the classifier of one combination.
+ *
+ * @param work The sweep
+ * @param run The combination
+ */
+static void sweep_run(const struct sweep_work *work, struct sweep_run *run);
+
+/**
+ * @brief Counts the nodes of a tree.
+ *
+ * @param cls The tree
+ * @param leaves Output: incremented by the count of leaves
+ * @return Count of nodes
+ */
+static int tree_size(const struct classifier *cls, int *leaves);
+
+/**
+ * @brief Closes the classifier files of the combinations.
+ *
+ * @param runs The combinations
+ * @param count Count of combinations
+ */
+static void close_runs(struct sweep_run *runs, int count);
+
+int id3_sweep_bootstrap_file(const struct sweep_options *opts,
+		FILE *attr_file, FILE *learn_file, FILE *out)
+{
+	struct example_set *lset, *hset;
+	struct description *descr;
+	struct sweep_work work;
+	struct sweep_run *run;
+	char *name, depth[12];
+	int i;
+
+	descr = read_description_file(attr_file);
+	CHECK(descr != NULL, nodescr);
+	lset = read_learning_file(learn_file, descr);
+	CHECK(lset != NULL, nolset);
+	hset = read_learning_file(opts->holdout, descr);
+	CHECK(hset != NULL, nohset);
+
+	work.descr = descr;
+	work.lset = lset;
+	work.hset = hset;
+	work.runs = calloc(3 * 2 * 4 * opts->depth_count,
+			sizeof(work.runs[0]));
+	work.count = list_runs(opts, work.runs);
+	/* the suffix is at most _full_maj_none and _ and a depth */
+	name = calloc(strlen(opts->prefix) + 16 + sizeof(depth),
+			sizeof(name[0]));
+	for (i = 0; i < work.count; i++) {
+		run = &work.runs[i];
+		sprintf(name, "%s_%s_%s_%s", opts->prefix,
+				num_names[run->num_handle],
+				missing_names[run->missing_handle],
+				prune_names[run->prune]);
+		if (run->max_depth)
+			sprintf(name + strlen(name), "_%d", run->max_depth);
+		run->file = fopen(name, "w");
+		CHECK(run->file != NULL, fail);
+	}
+	free(name);
+
+	run_tasks(opts->jobs, work.count, sweep_task, &work);
+
+	fprintf(out, "%-7s %-7s %-5s %-5s %6s %6s %6s %8s\n", "numeric",
+			"missing", "prune", "depth", "nodes", "leaves",
+			"tested", "accuracy");
+	for (i = 0; i < work.count; i++) {
+		run = &work.runs[i];
+		if (run->max_depth)
+			sprintf(depth, "%d", run->max_depth);
+		else
+			strcpy(depth, "none");
+		fprintf(out, "%-7s %-7s %-5s %-5s %6d %6d %6d %8.4f\n",
+				num_names[run->num_handle],
+				missing_names[run->missing_handle],
+				prune_names[run->prune], depth, run->nodes,
+				run->leaves, run->count,
+				(double)DIV(run->correct, run->count));
+	}
+
+	close_runs(work.runs, work.count);
+	free(work.runs);
+	free_example_set(hset);
+	free_and_set_NULL(hset);
+	free_example_set(lset);
+	free_and_set_NULL(lset);
+	free_description(descr);
+	free_and_set_NULL(descr);
+	return EXIT_SUCCESS;
+
+fail:
+	perror(name);
+	free(name);
+	close_runs(work.runs, work.count);
+	free(work.runs);
+	free_example_set(hset);
+	free_and_set_NULL(hset);
+nohset:
+	free_example_set(lset);
+	free_and_set_NULL(lset);
+nolset:
+	free_description(descr);
+	free_and_set_NULL(descr);
+nodescr:
+	return set_error(EINVAL);
+}
+
+int list_runs(const struct sweep_options *opts, struct sweep_run *runs)
+{
+	int n, m, p, d, count;
+
+	count = 0;
+	for (n = NUM_DIV; n <= NUM_LOCAL; n++) {
+		SKIPIF(!(opts->num_handles & SWEEP_BIT(n)));
+		for (m = MISS_MAJ; m <= MISS_PRB; m++) {
+			SKIPIF(!(opts->missing_handles & SWEEP_BIT(m)));
+			for (p = PRUNE_NONE; p <= PRUNE_REP; p++) {
+				SKIPIF(!(opts->prunes & SWEEP_BIT(p)));
+				for (d = 0; d < opts->depth_count; d++) {
+					runs[count].num_handle = n;
+					runs[count].missing_handle = m;
+					runs[count].prune = p;
+					runs[count].max_depth = opts->depths[d];
+					count++;
+				}
+			}
+		}
+	}
+	return count;
+}
+
+void sweep_task(void *arg, int index)
+{
+	struct sweep_work *work = arg;
+
+	sweep_run(work, &work->runs[index]);
+}
+
+void sweep_run(const struct sweep_work *work, struct sweep_run *run)
+{
+	const struct example_set *hset = work->hset;
+	struct description *descr;
+	struct example_set *lset;
+	struct learn_state st;
+	struct classifier *cls;
+	struct flat_tree *tree;
+	int i;
+
+	/* filling the missing values and the discretization change both */
+	descr = copy_description(work->descr);
+	lset = copy_example_set(work->lset, descr->M);
+
+	id3_prepare_set(descr, lset, run->num_handle, run->missing_handle, 1);
+	st.descr = descr;
+	st.lset = lset;
+	st.weight = NULL;
+	st.num_handle = run->num_handle;
+	st.features = 0;
+	st.seed = 0;
+	st.max_depth = run->max_depth;
+	cls = id3_learn_tree(&st);
+	if (run->prune != PRUNE_NONE)
+		cls = id3_prune(descr, lset, hset, cls, run->prune);
+	write_id3_temp_file(descr, cls, run->file);
+	run->nodes = tree_size(cls, &run->leaves);
+
+	tree = flatten_classifier(descr, cls);
+	for (i = 0; i < hset->N; i++) {
+		SKIPIF(hset->examples[i]->miss);
+		run->count++;
+		INCRIF(flat_classify(tree, hset->examples[i]->attr_ids) ==
+				hset->examples[i]->class_id, run->correct);
+	}
+
+	free_flat_tree(tree);
+	free_classifier(cls);
+	free_example_set(lset);
+	free_and_set_NULL(lset);
+	free_description(descr);
+	free_and_set_NULL(descr);
+}
+
+int tree_size(const struct classifier *cls, int *leaves)
+{
+	int i, count;
+
+	if (cls->C == 0)
+		(*leaves)++;
+	for (i = 0, count = 1; i < cls->C; i++)
+		count += tree_size(cls->cls[i], leaves);
+	return count;
+}
+
+void close_runs(struct sweep_run *runs, int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++)
+		if (runs[i].file)
+			fclose(runs[i].file);
+}
+
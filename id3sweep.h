@@ -0,0 +1,84 @@
+/*!
+ * @file id3sweep.h
+ * @brief Comparing the learning options of the id3 classifier.
+ * @author Mihai Maruseac (mihai@rosedu.org)
+ *
+ * @section DESCRIPTION
+ * IAUT1: ID3: Comparing the learning options of the id3 classifier.
+ *
+ * Contains the functions used to learn one classifier for each combination
+ * of several learning options, reading the input only once, and to compare
+ * them on a holdout set.
+ *
+ * @section QUOTE
+ * In theory, there is no difference between theory and practice. But, in
+ * practice, there is. (Jan L. A. van de Snepscheut)
+ *
+ * @bug No known bugs.
+ */
+
+#ifndef _ID3SWEEP_H
+#define _ID3SWEEP_H
+
+#include "globals.h"
+
+/**
+ * @brief Macro giving the bit of an option value in a set of values.
+ *
+ * @param val Value of the option (NUM_*, MISS_* or PRUNE_*)
+ */
+#define SWEEP_BIT(val) (1 << (val))
+
+/**
+ * @brief Maximum count of depth limits of a sweep.
+ */
+#define SWEEP_DEPTHS 8
+
+/**
+ * @brief Options of the sweep.
+ */
+struct sweep_options {
+	/** Ways to handle numeric arguments (SWEEP_BIT of each NUM_*) */
+	int num_handles;
+	/** Ways to handle missing arguments (SWEEP_BIT of each MISS_*) */
+	int missing_handles;
+	/** Ways to prune the learned trees (SWEEP_BIT of each PRUNE_*) */
+	int prunes;
+	/** Depth limits of the learned trees (0 for no limit) */
+	int depths[SWEEP_DEPTHS];
+	/** Count of depth limits */
+	int depth_count;
+	/** Count of threads learning classifiers */
+	int jobs;
+	/** Holdout set file */
+	FILE *holdout;
+	/** Prefix of the names of the classifier files */
+	const char *prefix;
+};
+
+/**
+ * @brief Bootstraps the sweep by reading data from the input files.
+ *
+ * The learning set is read once and each combination of options gets a copy
+ * of it (and of the description), taken before the missing values are
+ * filled, since filling them and the discretization change both. Up to
+ * opts->jobs combinations are learned at the same time.
+ *
+ * The classifier of each combination is written to the file named
+ * prefix_NUM_MISS_PRUNE (for example dump_div_maj_pes), followed by _DEPTH
+ * for a limited depth (for example dump_div_maj_pes_3). A table giving for
+ * each combination the count of nodes and leaves of the tree, the count of
+ * holdout examples tested (examples with missing values are skipped) and
+ * the accuracy on them is written to out.
+ *
+ * @param opts Options.
+ * @param attr_file File containing the attribute description.
+ * @param learn_file File containing the example set.
+ * @param out File to write the table to.
+ * @return The exit code for the sweep.
+ */
+int id3_sweep_bootstrap_file(const struct sweep_options *opts,
+		FILE *attr_file, FILE *learn_file, FILE *out);
+
+#endif
+
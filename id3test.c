@@ -14,80 +14,1000 @@
  * @bug No known bugs.
  */
 
+#include <pthread.h>
+
 #include "globals.h"
+#include "id3cache.h"
+#include "id3flat.h"
 #include "id3test.h"
 
 /**
- * @brief Classifies an example
+ * @brief Class stored in the cache for an example waiting to be classified
+ * in batch mode, n being its index among the examples not found in the
+ * cache. The macro is its own inverse.
+ */
+#define CACHE_PENDING(n) (CACHE_MISS - 1 - (n))
+
+/**
+ * @brief Structure representing a loaded classifier.
+ */
+struct test_model {
+	/** Description */
+	struct description *descr;
+	/** Count of trees (more than 1 for a forest) */
+	int count;
+	/** Flattened trees (if not in batch mode) */
+	struct flat_tree **trees;
+	/** Binary trees (in batch mode) */
+	struct batch_tree **batches;
+	/** Table of an oblivious classifier, used instead of the trees (NULL
+	 * if the classifier is not oblivious)
+	 */
+	struct oblivious_tree *oblivious;
+	/** Attributes tested by the classifier (used[i] is 1 if tested) */
+	int *used;
+	/** Count of cache lookups done by all threads */
+	long long lookups;
+	/** Count of cache hits of all threads */
+	long long hits;
+	/** Visit count of each node of the flattened tree (if recorded) */
+	long long *visits;
+};
+
+/**
+ * @brief Work shared by the threads classifying the files of a list.
+ */
+struct test_list {
+	/** The classifier */
+	struct test_model *model;
+	/** Options used for each file */
+	struct test_options opts;
+	/** Test files */
+	char **tests;
+	/** Output files */
+	char **outs;
+	/** Count of files */
+	int count;
+	/** Count of files which could not be classified */
+	int failed;
+};
+
+/**
+ * @brief Block of examples parsed and classified by one thread.
+ *
+ * The output of the thread is written to a private buffer, to be copied to
+ * the real output in the order of the blocks.
+ */
+struct test_block {
+	/** Description */
+	const struct description *descr;
+	/** Attributes tested by the classifier (the only ones decoded) */
+	const int *used;
+	/** Count of trees (more than 1 for a forest) */
+	int count;
+	/** Flattened trees (if not in batch mode) */
+	struct flat_tree *const *trees;
+	/** Binary trees (in batch mode) */
+	struct batch_tree *const *batches;
+	/** Table of an oblivious classifier (NULL if not oblivious) */
+	const struct oblivious_tree *oblivious;
+	/** Votes for each class (K for each example of the block, forest
+	 * only)
+	 */
+	int *votes;
+	/** Classes given by one tree of the forest (in batch mode) */
+	int *answers;
+	/** Room of the block, in examples */
+	int size;
+	/** Count of examples of the block */
+	int N;
+	/** Lines of the examples, as read */
+	char **lines;
+	/** Sizes of the line buffers */
+	size_t *sizes;
+	/** Attribute values of the examples, one example after another */
+	int *values;
+	/** Missing attributes of each example (MISS_COUNT for each example,
+	 * -1 for unused entries)
+	 */
+	int *missing;
+	/** Set if the block could not be parsed or classified */
+	int failed;
+	/** Set when the block is classified (with a pool of threads) */
+	int done;
+	/** Attribute values of the examples not found in the cache (in batch
+	 * mode)
+	 */
+	int *rows;
+	/** Classes of the examples (in batch mode) */
+	int *classes;
+	/** Cache of classes of recent examples (NULL if not used) */
+	struct leaf_cache *cache;
+	/** Class of each example (in batch mode, with cache) */
+	int *results;
+	/** Indexes of examples not found in the cache (batch mode) */
+	int *misses;
+	/** Cache slots of examples not found in the cache (batch mode) */
+	unsigned *slots;
+	/** Visit count of each node of the tree (if recorded) */
+	long long *visits;
+	/** Output buffer */
+	char *buf;
+	/** Length of output buffer */
+	size_t len;
+};
+
+/**
+ * @brief Threads parsing and classifying the blocks of a test file.
+ *
+ * The main thread reads the lines of the examples into the blocks, used in
+ * turn, and writes the answers of the blocks in the same order.
+ */
+struct test_pool {
+	/** The blocks */
+	struct test_block *blocks;
+	/** Count of blocks */
+	int count;
+	/** Count of blocks given to the threads */
+	int queued;
+	/** Count of blocks taken by the threads */
+	int taken;
+	/** Set when no more blocks are given */
+	int stop;
+	/** Protects the fields above and the done flags of the blocks */
+	pthread_mutex_t lock;
+	/** Signaled when a block is given or on stop */
+	pthread_cond_t filled;
+	/** Signaled when a block is classified */
+	pthread_cond_t classified;
+};
+
+/**
+ * @brief Reads the classifier and builds the form used for classification.
  *
- * @param descr Description
- * @param cls Classifier
- * @param ex Example
+ * @param id3 File containing the classifier
+ * @param opts Classification options
+ * @param model Output: the loaded classifier
+ * @return 0 on success, -1 on error
+ */
+static int load_model(FILE *id3, const struct test_options *opts,
+		struct test_model *model);
+
+/**
+ * @brief Frees a loaded classifier.
+ *
+ * @param model The classifier
+ */
+static void free_model(struct test_model *model);
+
+/**
+ * @brief Classifies all the examples of a test file.
+ *
+ * Cache statistics and node visits are added to the ones of the model.
+ *
+ * @param model The classifier
+ * @param test File containing the test instances
+ * @param out File to output to.
+ * @param opts Classification options
+ * @return 0 on success, -1 on error
+ */
+static int test_file(struct test_model *model, FILE *test, FILE *out,
+		const struct test_options *opts);
+
+/**
+ * @brief Prints the cache statistics to stderr and writes the recorded
+ * profile, if requested by the options.
+ *
+ * @param model The classifier
+ * @param opts Classification options
+ */
+static void test_report(const struct test_model *model,
+		const struct test_options *opts);
+
+/**
+ * @brief Reads the list of files to classify.
+ *
+ * @param list File containing the list
+ * @param work Output: the files
+ * @return 0 on success, -1 on error
+ */
+static int read_list(FILE *list, struct test_list *work);
+
+/**
+ * @brief Task classifying one file of a list (see run_tasks).
+ *
+ * @param arg The struct test_list
+ * @param index Index of file
+ */
+static void classify_task(void *arg, int index);
+
+/**
+ * @brief Classifies one file of a list.
+ *
+ * @param work The list
+ * @param index Index of the file
+ * @return 0 on success, -1 on error
+ */
+static int classify_file(struct test_list *work, int index);
+
+/**
+ * @brief Classifies the examples of a block.
+ *
+ * @param block The block
  * @param out Output
  */
-static void classify(const struct description *descr,
-		const struct classifier *cls, const struct example *ex,
-		FILE *out);
+static void classify(struct test_block *block, FILE *out);
 
-int id3_test(FILE *id3, FILE *test, FILE *out)
+/**
+ * @brief Classifies one example using the flattened tree and the cache of
+ * the block, if any.
+ *
+ * @param block The block
+ * @param attr_ids Attribute values of the example
+ * @return Id of class or -1 if the class is unknown.
+ */
+static int classify_example(struct test_block *block, const int *attr_ids);
+
+/**
+ * @brief Classifies one example using the flattened trees (by majority vote
+ * for a forest).
+ *
+ * @param block The block
+ * @param attr_ids Attribute values of the example
+ * @return Id of class or -1 if the class is unknown.
+ */
+static int flat_vote(struct test_block *block, const int *attr_ids);
+
+/**
+ * @brief Classifies several examples using the binary trees (by majority
+ * vote for a forest).
+ *
+ * @param block The block
+ * @param rows Values of the attributes, one example after another
+ * @param count Count of examples
+ * @param classes Output: id of class (or -1) for each example
+ */
+static void batch_vote(struct test_block *block, const int *rows, int count,
+		int *classes);
+
+/**
+ * @brief Returns the class with most votes.
+ *
+ * @param votes Votes for each class
+ * @param K Count of classes
+ * @return Id of class (the first one for ties) or -1 if there are no votes.
+ */
+static int majority(const int *votes, int K);
+
+/**
+ * @brief Classifies the examples of a block in batch mode, using the cache
+ * of the block: only the examples not found in the cache are classified.
+ *
+ * @param block The block
+ */
+static void classify_cached(struct test_block *block);
+
+/**
+ * @brief Allocates the blocks used for classification.
+ *
+ * @param model The classifier
+ * @param opts Classification options
+ * @param size Room of each block, in examples
+ * @param count Count of blocks
+ * @return The blocks
+ */
+static struct test_block *alloc_blocks(const struct test_model *model,
+		const struct test_options *opts, int size, int count);
+
+/**
+ * @brief Classifies the examples of a test file in the calling thread.
+ *
+ * @param block The only block
+ * @param test File containing the test instances (after the header)
+ * @param out File to output to.
+ * @param N Count of examples
+ * @param missing Set recording the missing attributes of the file
+ * @param stream Flush the output after each block
+ * @return 0 on success, -1 on error
+ */
+static int test_serial(struct test_block *block, FILE *test, FILE *out,
+		int N, struct example_set *missing, int stream);
+
+/**
+ * @brief Classifies the examples of a test file with a pool of threads.
+ *
+ * @param pool The pool (blocks and count are set)
+ * @param jobs Count of threads
+ * @param test File containing the test instances (after the header)
+ * @param out File to output to.
+ * @param N Count of examples
+ * @param missing Set recording the missing attributes of the file
+ * @param stream Flush the output after each block
+ * @return 0 on success, -1 on error (1 if no thread could be started)
+ */
+static int test_pool(struct test_pool *pool, int jobs, FILE *test,
+		FILE *out, int N, struct example_set *missing, int stream);
+
+/**
+ * @brief Reads the lines of the next count examples into a block.
+ *
+ * Blank lines (such as the end of the header line) are skipped.
+ *
+ * @param test File containing the test instances
+ * @param block The block, with room for count examples
+ * @param count Count of examples to read
+ * @return 0 on success, -1 on error
+ */
+static int read_lines(FILE *test, struct test_block *block, int count);
+
+/**
+ * @brief Parses the lines of a block.
+ *
+ * Only the attributes tested by the classifier are decoded. Sets the
+ * failed flag of the block on error.
+ *
+ * @param block The block
+ */
+static void parse_block(struct test_block *block);
+
+/**
+ * @brief Records the missing attributes of a block in the set of the file.
+ *
+ * The blocks must be given in order, so that a file with too many missing
+ * attributes is rejected at the same example whatever the count of threads.
+ *
+ * @param block The block
+ * @param missing Set recording the missing attributes of the file
+ * @return 0 on success, -1 if the block failed or there are too many
+ * missing attributes
+ */
+static int check_block(const struct test_block *block,
+		struct example_set *missing);
+
+/**
+ * @brief Parses and classifies one block to its private buffer.
+ *
+ * @param block The block
+ */
+static void classify_block(struct test_block *block);
+
+/**
+ * @brief Thread function classifying the blocks of a pool until stopped.
+ *
+ * @param arg The struct test_pool
+ * @return NULL
+ */
+static void *classify_blocks(void *arg);
+
+/**
+ * @brief Frees the blocks used for classification.
+ *
+ * @param blocks The blocks
+ * @param count Count of blocks
+ */
+static void free_blocks(struct test_block *blocks, int count);
+
+int id3_test(FILE *id3, FILE *test, FILE *out,
+		const struct test_options *opts)
 {
-	struct description *descr;
-	struct classifier *cls;
-	struct example_set *lset;
+	struct test_model model;
+	int status;
+
+	CHECK(load_model(id3, opts, &model) == 0, fail);
+	status = test_file(&model, test, out, opts);
+	test_report(&model, opts);
+	free_model(&model);
+	CHECK(status == 0, fail);
+	return 0;
+fail:
+	return set_error(EINVAL);
+}
+
+int id3_test_list(FILE *id3, FILE *list, const struct test_options *opts)
+{
+	struct test_model model;
+	struct test_list work;
 	int i;
 
-	descr = read_description_file(id3);
-	CHECK(descr != NULL, nodescr);
-	cls = read_classifier(id3);
-	CHECK(cls != NULL, fail);
-	lset = read_testing_file(test, descr);
-	CHECK(lset != NULL, nolset);
+	memset(&work, 0, sizeof(work));
+	CHECK(load_model(id3, opts, &model) == 0, nomodel);
+	CHECK(read_list(list, &work) == 0, fail);
+	work.model = &model;
+	work.opts = *opts;
+	work.opts.jobs = 1;
 
-	for (i = 0; i < lset->N; i++)
-		classify(descr, cls, lset->examples[i], out);
+	run_tasks(opts->jobs, work.count, classify_task, &work);
+	test_report(&model, opts);
+	CHECK(work.failed == 0, fail);
 
-	free_description(descr);
-	free_and_set_NULL(descr);
-	free_classifier(cls);
-	free_example_set(lset);
-	free_and_set_NULL(lset);
+	free_model(&model);
+	for (i = 0; i < work.count; i++) {
+		free(work.tests[i]);
+		free(work.outs[i]);
+	}
+	free(work.tests);
+	free(work.outs);
 	return 0;
-nolset:
-	free_example_set(lset);
-	free_and_set_NULL(lset);
 fail:
+	free_model(&model);
+	for (i = 0; i < work.count; i++) {
+		free(work.tests[i]);
+		free(work.outs[i]);
+	}
+	free(work.tests);
+	free(work.outs);
+nomodel:
+	return set_error(EINVAL);
+}
+
+int load_model(FILE *id3, const struct test_options *opts,
+		struct test_model *model)
+{
+	struct flat_profile *profile;
+	struct classifier *cls;
+	int i;
+
+	memset(model, 0, sizeof(*model));
+	model->descr = read_description_file(id3);
+	CHECK(model->descr != NULL, nodescr);
+	model->count = read_forest_size(id3);
+	CHECK(model->count > 0, fail);
+	/* profiles describe a single tree */
+	CHECK(model->count == 1 || (!opts->layout && !opts->record), fail);
+	model->trees = calloc(model->count, sizeof(model->trees[0]));
+	model->batches = calloc(model->count, sizeof(model->batches[0]));
+	model->used = calloc(model->descr->M, sizeof(model->used[0]));
+
+	for (i = 0; i < model->count; i++) {
+		cls = read_classifier(id3);
+		CHECK(cls != NULL, fail);
+		if (opts->batch)
+			model->batches[i] = batch_compile(model->descr, cls);
+		else if (opts->layout) {
+			profile = read_profile(opts->layout);
+			CHECK(profile != NULL, noprofile);
+			model->trees[i] = flatten_profiled(model->descr, cls,
+					profile);
+			free_profile(profile);
+		} else
+			model->trees[i] = flatten_classifier(model->descr, cls);
+		/* the table is not walked, thus it can't record visits */
+		if (model->count == 1 && !opts->record)
+			model->oblivious = oblivious_compile(model->descr, cls);
+		classifier_attributes(cls, model->used);
+		free_classifier(cls);
+	}
+	if (opts->record)
+		model->visits = calloc(model->trees[0]->count,
+				sizeof(model->visits[0]));
+	return 0;
+noprofile:
 	free_classifier(cls);
-	free_description(descr);
-	free_and_set_NULL(descr);
+fail:
+	free_model(model);
 nodescr:
-	return set_error(EINVAL);
+	return -1;
 }
 
-void classify(const struct description *descr,
-		const struct classifier *cls, const struct example *ex,
-		FILE *out)
+void free_model(struct test_model *model)
 {
 	int i;
 
-	if (cls->C == 0) {
-		fprintf(out, "%s\n", descr->classes[cls->id]);
-		return;
+	for (i = 0; i < model->count && model->trees; i++) {
+		free_flat_tree(model->trees[i]);
+		free_batch_tree(model->batches[i]);
+	}
+	free_and_set_NULL(model->trees);
+	free_and_set_NULL(model->batches);
+	free_oblivious_tree(model->oblivious);
+	model->oblivious = NULL;
+	free_and_set_NULL(model->used);
+	free_and_set_NULL(model->visits);
+	free_description(model->descr);
+	free_and_set_NULL(model->descr);
+}
+
+int test_file(struct test_model *model, FILE *test, FILE *out,
+		const struct test_options *opts)
+{
+	struct example_set missing;
+	struct test_block *blocks;
+	struct test_pool pool;
+	int N, i, j, size, count, status;
+
+	N = read_testing_header(test);
+	CHECK(N >= 0, fail);
+
+	/* the main thread reads ahead while the blocks are classified */
+	size = opts->stream ? 1 : TEST_BLOCK;
+	count = opts->jobs > 1 ? 2 * opts->jobs : 1;
+	blocks = alloc_blocks(model, opts, size, count);
+	memset(&missing, 0, sizeof(missing));
+
+	status = 1;
+	if (count > 1) {
+		pool.blocks = blocks;
+		pool.count = count;
+		status = test_pool(&pool, opts->jobs, test, out, N, &missing,
+				opts->stream);
+	}
+	if (status == 1)
+		status = test_serial(&blocks[0], test, out, N, &missing,
+				opts->stream);
+
+	for (j = 0; j < count && model->visits; j++)
+		for (i = 0; i < model->trees[0]->count; i++)
+			__atomic_fetch_add(&model->visits[i],
+					blocks[j].visits[i], __ATOMIC_RELAXED);
+	for (j = 0; j < count; j++) {
+		SKIPIF(blocks[j].cache == NULL);
+		__atomic_fetch_add(&model->lookups, blocks[j].cache->lookups,
+				__ATOMIC_RELAXED);
+		__atomic_fetch_add(&model->hits, blocks[j].cache->hits,
+				__ATOMIC_RELAXED);
+	}
+	free_blocks(blocks, count);
+	return status;
+fail:
+	return -1;
+}
+
+struct test_block *alloc_blocks(const struct test_model *model,
+		const struct test_options *opts, int size, int count)
+{
+	const struct description *descr = model->descr;
+	struct test_block *blocks;
+	int j;
+
+	blocks = calloc(count, sizeof(blocks[0]));
+	for (j = 0; j < count; j++) {
+		blocks[j].descr = descr;
+		blocks[j].used = model->used;
+		blocks[j].count = model->count;
+		blocks[j].trees = model->trees;
+		blocks[j].batches = model->batches;
+		blocks[j].oblivious = model->oblivious;
+		blocks[j].size = size;
+		blocks[j].lines = calloc(size, sizeof(blocks[j].lines[0]));
+		blocks[j].sizes = calloc(size, sizeof(blocks[j].sizes[0]));
+		blocks[j].values = calloc(size * descr->M,
+				sizeof(blocks[j].values[0]));
+		blocks[j].missing = calloc(size * MISS_COUNT,
+				sizeof(blocks[j].missing[0]));
+		if (model->count > 1)
+			blocks[j].votes = calloc(size * descr->K,
+					sizeof(blocks[j].votes[0]));
+		if (opts->cache)
+			blocks[j].cache = cache_create(model->used, descr->M,
+					opts->cache);
+		if (model->visits)
+			blocks[j].visits = calloc(model->trees[0]->count,
+					sizeof(blocks[j].visits[0]));
+		SKIPIF(!opts->batch);
+		blocks[j].classes = calloc(size,
+				sizeof(blocks[j].classes[0]));
+		if (model->count > 1)
+			blocks[j].answers = calloc(size,
+					sizeof(blocks[j].answers[0]));
+		SKIPIF(blocks[j].cache == NULL);
+		blocks[j].rows = calloc(size * descr->M,
+				sizeof(blocks[j].rows[0]));
+		blocks[j].results = calloc(size,
+				sizeof(blocks[j].results[0]));
+		blocks[j].misses = calloc(size,
+				sizeof(blocks[j].misses[0]));
+		blocks[j].slots = calloc(size, sizeof(blocks[j].slots[0]));
+	}
+	return blocks;
+}
+
+int test_serial(struct test_block *block, FILE *test, FILE *out,
+		int N, struct example_set *missing, int stream)
+{
+	int i;
+
+	while (N) {
+		i = N < block->size ? N : block->size;
+		CHECK(read_lines(test, block, i) == 0, fail);
+		N -= i;
+		parse_block(block);
+		CHECK(check_block(block, missing) == 0, fail);
+		classify(block, out);
+		if (stream)
+			fflush(out);
 	}
+	return 0;
+fail:
+	return -1;
+}
+
+int test_pool(struct test_pool *pool, int jobs, FILE *test, FILE *out,
+		int N, struct example_set *missing, int stream)
+{
+	struct test_block *block;
+	int i, started, queued, written, status;
+	pthread_t *threads;
+
+	pool->queued = 0;
+	pool->taken = 0;
+	pool->stop = 0;
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->filled, NULL);
+	pthread_cond_init(&pool->classified, NULL);
+	threads = calloc(jobs, sizeof(threads[0]));
+	for (started = 0; started < jobs; started++)
+		if (pthread_create(&threads[started], NULL, classify_blocks,
+					pool))
+			break;
 
-	if (descr->attribs[cls->id]->type == NUMERIC) {
-		for (i = 0; i < cls->C - 1; i++)
-			if (ex->attr_ids[cls->id] < cls->values[i]) {
-				classify(descr, cls->cls[i], ex, out);
-				return;
+	status = started ? 0 : 1;
+	queued = 0;
+	written = 0;
+	while (started && (N || written < queued)) {
+		/* give a new block while one is free */
+		if (N && queued - written < pool->count) {
+			block = &pool->blocks[queued % pool->count];
+			i = N < block->size ? N : block->size;
+			if (read_lines(test, block, i)) {
+				status = -1;
+				break;
 			}
-		classify(descr, cls->cls[i], ex, out);
+			N -= i;
+			pthread_mutex_lock(&pool->lock);
+			block->done = 0;
+			pool->queued = ++queued;
+			pthread_cond_signal(&pool->filled);
+			pthread_mutex_unlock(&pool->lock);
+			continue;
+		}
+
+		/* otherwise write the oldest block */
+		block = &pool->blocks[written % pool->count];
+		pthread_mutex_lock(&pool->lock);
+		while (!block->done)
+			pthread_cond_wait(&pool->classified, &pool->lock);
+		pthread_mutex_unlock(&pool->lock);
+		if (check_block(block, missing)) {
+			status = -1;
+			break;
+		}
+		fwrite(block->buf, 1, block->len, out);
+		block->buf = free_and_set_NULL(block->buf);
+		if (stream)
+			fflush(out);
+		written++;
+	}
+
+	pthread_mutex_lock(&pool->lock);
+	pool->stop = 1;
+	pthread_cond_broadcast(&pool->filled);
+	pthread_mutex_unlock(&pool->lock);
+	for (i = 0; i < started; i++)
+		pthread_join(threads[i], NULL);
+	free(threads);
+	pthread_cond_destroy(&pool->classified);
+	pthread_cond_destroy(&pool->filled);
+	pthread_mutex_destroy(&pool->lock);
+	return status;
+}
+
+void test_report(const struct test_model *model,
+		const struct test_options *opts)
+{
+	if (opts->cache)
+		fprintf(stderr, "Cache: %lld lookups, %lld hits (%.2f%%)\n",
+				model->lookups, model->hits, model->lookups ?
+				100.0 * model->hits / model->lookups : 0.0);
+	if (opts->record)
+		write_profile(model->trees[0], model->visits, opts->record);
+}
+
+int read_list(FILE *list, struct test_list *work)
+{
+	char *test = NULL, *out = NULL;
+	int size = 0;
+
+	while (fscanf(list, "%ms %ms", &test, &out) == 2) {
+		if (work->count == size) {
+			size = size ? 2 * size : 16;
+			work->tests = realloc(work->tests,
+					size * sizeof(work->tests[0]));
+			work->outs = realloc(work->outs,
+					size * sizeof(work->outs[0]));
+		}
+		work->tests[work->count] = test;
+		work->outs[work->count] = out;
+		work->count++;
+		test = NULL;
+		out = NULL;
+	}
+	CHECK(test == NULL && feof(list), fail);
+	return 0;
+fail:
+	free_and_set_NULL(test);
+	return -1;
+}
+
+void classify_task(void *arg, int index)
+{
+	struct test_list *work = arg;
+
+	if (classify_file(work, index))
+		__atomic_fetch_add(&work->failed, 1, __ATOMIC_RELAXED);
+}
+
+int classify_file(struct test_list *work, int index)
+{
+	FILE *test, *out;
+	int status;
+
+	test = fopen(work->tests[index], "r");
+	CHECK(test != NULL, notest);
+	out = fopen(work->outs[index], "w");
+	CHECK(out != NULL, noout);
+	status = test_file(work->model, test, out, &work->opts);
+	if (status)
+		fprintf(stderr, "Invalid test file %s\n", work->tests[index]);
+	fclose(out);
+	fclose(test);
+	return status;
+noout:
+	fprintf(stderr, "Cannot open output file %s\n", work->outs[index]);
+	fclose(test);
+	return -1;
+notest:
+	fprintf(stderr, "Cannot open test file %s\n", work->tests[index]);
+	return -1;
+}
+
+int read_lines(FILE *test, struct test_block *block, int count)
+{
+	char *line;
+
+	block->N = 0;
+	block->failed = 0;
+	while (block->N < count) {
+		CHECK(getline(&block->lines[block->N],
+				&block->sizes[block->N], test) != -1, fail);
+		line = block->lines[block->N];
+		SKIPIF(line[strspn(line, " \t\r\n")] == '\0');
+		block->N++;
+	}
+	return 0;
+fail:
+	return -1;
+}
+
+void parse_block(struct test_block *block)
+{
+	int i, M;
+
+	M = block->descr->M;
+	for (i = 0; i < block->N; i++) {
+		SKIPIF(parse_testing_example(block->lines[i], block->descr,
+				block->used, block->values + i * M,
+				block->missing + i * MISS_COUNT) == 0);
+		block->failed = 1;
 		return;
 	}
+}
+
+int check_block(const struct test_block *block, struct example_set *missing)
+{
+	int i;
 
-	for (i = 0; i < cls->C; i++)
-		if (ex->attr_ids[cls->id] == cls->values[i]) {
-			classify(descr, cls->cls[i], ex, out);
-			return;
+	CHECK(!block->failed, fail);
+	for (i = 0; i < block->N * MISS_COUNT; i++) {
+		SKIPIF(block->missing[i] == -1);
+		CHECK(record_missing(block->missing[i], missing) != 0, fail);
+	}
+	return 0;
+fail:
+	return -1;
+}
+
+void classify_block(struct test_block *block)
+{
+	FILE *out;
+
+	parse_block(block);
+	if (block->failed)
+		return;
+	out = open_memstream(&block->buf, &block->len);
+	if (out == NULL) {
+		block->failed = 1;
+		return;
+	}
+	classify(block, out);
+	fclose(out);
+}
+
+void *classify_blocks(void *arg)
+{
+	struct test_pool *pool = arg;
+	struct test_block *block;
+
+	pthread_mutex_lock(&pool->lock);
+	while (1) {
+		while (pool->taken == pool->queued && !pool->stop)
+			pthread_cond_wait(&pool->filled, &pool->lock);
+		if (pool->taken == pool->queued)
+			break;
+		block = &pool->blocks[pool->taken++ % pool->count];
+		pthread_mutex_unlock(&pool->lock);
+
+		classify_block(block);
+
+		pthread_mutex_lock(&pool->lock);
+		block->done = 1;
+		pthread_cond_broadcast(&pool->classified);
+	}
+	pthread_mutex_unlock(&pool->lock);
+	return NULL;
+}
+
+void free_blocks(struct test_block *blocks, int count)
+{
+	int i, j;
+
+	for (i = 0; i < count; i++) {
+		for (j = 0; j < blocks[i].size; j++)
+			free(blocks[i].lines[j]);
+		free_and_set_NULL(blocks[i].lines);
+		free_and_set_NULL(blocks[i].sizes);
+		free_and_set_NULL(blocks[i].values);
+		free_and_set_NULL(blocks[i].missing);
+		free_and_set_NULL(blocks[i].buf);
+		free_and_set_NULL(blocks[i].rows);
+		free_and_set_NULL(blocks[i].classes);
+		free_cache(blocks[i].cache);
+		free_and_set_NULL(blocks[i].results);
+		free_and_set_NULL(blocks[i].misses);
+		free_and_set_NULL(blocks[i].slots);
+		free_and_set_NULL(blocks[i].visits);
+		free_and_set_NULL(blocks[i].votes);
+		free_and_set_NULL(blocks[i].answers);
+	}
+	free(blocks);
+}
+
+void classify(struct test_block *block, FILE *out)
+{
+	const struct description *descr = block->descr;
+	int i, id, M;
+
+	M = descr->M;
+	if (block->batches[0] == NULL) {
+		for (i = 0; i < block->N; i++) {
+			id = classify_example(block, block->values + i * M);
+			fprintf(out, "%s\n", id != -1 ? descr->classes[id] :
+					"unknown");
+		}
+		return;
+	}
+
+	if (block->cache) {
+		classify_cached(block);
+		for (i = 0; i < block->N; i++) {
+			id = block->results[i];
+			fprintf(out, "%s\n", id != -1 ? descr->classes[id] :
+					"unknown");
+		}
+		return;
+	}
+
+	batch_vote(block, block->values, block->N, block->classes);
+	for (i = 0; i < block->N; i++) {
+		id = block->classes[i];
+		fprintf(out, "%s\n", id != -1 ? descr->classes[id] :
+				"unknown");
+	}
+}
+
+int classify_example(struct test_block *block, const int *attr_ids)
+{
+	unsigned slot;
+	int id;
+
+	if (block->visits)
+		return flat_classify_profile(block->trees[0], attr_ids,
+				block->visits);
+	if (block->cache == NULL)
+		return flat_vote(block, attr_ids);
+
+	id = cache_lookup(block->cache, attr_ids, &slot);
+	if (id == CACHE_MISS) {
+		id = flat_vote(block, attr_ids);
+		cache_store(block->cache, slot, attr_ids, id);
+	}
+	return id;
+}
+
+void classify_cached(struct test_block *block)
+{
+	const int *attr_ids;
+	int i, n, M, id;
+
+	M = block->descr->M;
+	for (i = 0, n = 0; i < block->N; i++) {
+		attr_ids = block->values + i * M;
+		block->results[i] = cache_lookup(block->cache, attr_ids,
+				&block->slots[n]);
+		SKIPIF(block->results[i] != CACHE_MISS);
+		/* repeated examples of this block wait for the first one */
+		cache_store(block->cache, block->slots[n], attr_ids,
+				CACHE_PENDING(n));
+		memcpy(block->rows + n * M, attr_ids,
+				M * sizeof(block->rows[0]));
+		block->misses[n++] = i;
+	}
+
+	batch_vote(block, block->rows, n, block->classes);
+	for (i = 0; i < n; i++) {
+		block->results[block->misses[i]] = block->classes[i];
+		cache_store(block->cache, block->slots[i],
+				block->rows + i * M, block->classes[i]);
+	}
+	for (i = 0; i < block->N; i++) {
+		id = block->results[i];
+		SKIPIF(id >= -1);
+		block->results[i] = block->classes[CACHE_PENDING(id)];
+	}
+}
+
+int flat_vote(struct test_block *block, const int *attr_ids)
+{
+	int i, id, K;
+
+	if (block->oblivious)
+		return oblivious_classify(block->oblivious, attr_ids);
+	if (block->count == 1)
+		return flat_classify(block->trees[0], attr_ids);
+
+	K = block->descr->K;
+	memset(block->votes, 0, K * sizeof(block->votes[0]));
+	for (i = 0; i < block->count; i++) {
+		id = flat_classify(block->trees[i], attr_ids);
+		SKIPIF(id == -1);
+		block->votes[id]++;
+	}
+	return majority(block->votes, K);
+}
+
+void batch_vote(struct test_block *block, const int *rows, int count,
+		int *classes)
+{
+	int i, j, K;
+
+	if (block->oblivious) {
+		oblivious_classify_batch(block->oblivious, rows, count,
+				classes);
+		return;
+	}
+	if (block->count == 1) {
+		batch_classify(block->batches[0], rows, count, classes);
+		return;
+	}
+
+	K = block->descr->K;
+	memset(block->votes, 0, count * K * sizeof(block->votes[0]));
+	for (i = 0; i < block->count; i++) {
+		batch_classify(block->batches[i], rows, count, block->answers);
+		for (j = 0; j < count; j++) {
+			SKIPIF(block->answers[j] == -1);
+			block->votes[j * K + block->answers[j]]++;
 		}
+	}
+	for (j = 0; j < count; j++)
+		classes[j] = majority(block->votes + j * K, K);
 }
 
+int majority(const int *votes, int K)
+{
+	int k, best;
+
+	for (k = 1, best = 0; k < K; k++)
+		if (votes[k] > votes[best])
+			best = k;
+	return votes[best] ? best : -1;
+}
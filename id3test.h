@@ -17,15 +17,75 @@
 #ifndef _ID3TEST_H
 #define _ID3TEST_H
 
+#include <stdio.h>
+
+#define TEST_BLOCK 1024 /**< @brief Examples read at once when classifying */
+
+/**
+ * @brief Options of the classifying phase.
+ */
+struct test_options {
+	/** Classify one example at a time if not 0 */
+	int stream;
+	/** Count of threads used to classify blocks of examples */
+	int jobs;
+	/** Classify groups of examples in lockstep (batch mode) if not 0 */
+	int batch;
+	/** Count of slots of the cache of each thread (0 for no cache) */
+	int cache;
+	/** Profile used to lay out the flattened tree (NULL for none) */
+	FILE *layout;
+	/** File to write the visits of the nodes to (NULL for none) */
+	FILE *record;
+};
+
 /**
  * @brief Bootstraps the classifying phase.
  *
+ * The test instances are read and classified in blocks of TEST_BLOCK
+ * examples, thus memory usage doesn't depend on the size of the test file.
+ * In streaming mode, each example is classified (and the output flushed) as
+ * soon as it is read.
+ *
+ * With more than one job, up to jobs blocks are read at once and classified
+ * in parallel. Each thread writes to a private buffer and the buffers are
+ * output in the order of the blocks, thus the output doesn't depend on the
+ * number of jobs.
+ *
+ * In batch mode, the examples of a block are moved through a binary form of
+ * the tree BATCH_LANES at a time (see batch_classify).
+ *
+ * With a cache, each thread remembers the classes of the examples it has
+ * seen recently (see struct leaf_cache) and repeated examples are not
+ * classified again. Statistics of the cache are printed to stderr at the
+ * end.
+ *
+ * The visits of the nodes of the flattened tree can be recorded and written
+ * as a profile, to be used later to lay out the tree (see
+ * flatten_profiled).
+ *
  * @param id3 File containing the classifier
  * @param test File containing the test instances
  * @param out File to output to.
+ * @param opts Classification options
+ * @return error status or 0
+ */
+int id3_test(FILE *id3, FILE *test, FILE *out,
+		const struct test_options *opts);
+
+/**
+ * @brief Classifies the files of a list, loading the classifier only once.
+ *
+ * The list contains pairs of file names: a test file and the file to output
+ * its classes to. Up to opts->jobs files are classified at the same time,
+ * each by a single thread. The other options are used for every file.
+ *
+ * @param id3 File containing the classifier
+ * @param list File containing the list of files
+ * @param opts Classification options
  * @return error status or 0
  */
-int id3_test(FILE *id3, FILE *test, FILE *out);
+int id3_test_list(FILE *id3, FILE *list, const struct test_options *opts);
 
 #endif
 
@@ -0,0 +1,275 @@
+/*!
+ * @file libtest.c
+ * @brief Test program of the id3 library.
+ * @author Mihai Maruseac (mihai@rosedu.org)
+ *
+ * @section DESCRIPTION
+ * IAUT1: ID3: Test program of the id3 library.
+ *
+ * Does what id3 l and id3 c do, but only through the library interface:
+ * learns a classifier from examples given by columns, writes it, loads it
+ * back from a buffer and classifies the testing examples with it.
+ *
+ * Usage: libtest div|full|loc maj|prb ATTRIBUTES LEARNING TESTING MODEL OUT
+ *
+ * @section QUOTE
+ * Program testing can be used to show the presence of bugs, but never to
+ * show their absence. (Edsger Dijkstra)
+ *
+ * @bug No known bugs.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "id3lib.h"
+
+/**
+ * @brief A leaf, added to a description to get a model able to parse the
+ * examples of the problem.
+ */
+#define LEAF "\n0 0 0\n"
+
+/**
+ * @brief Reads a whole file in a buffer.
+ *
+ * @param name Name of the file
+ * @param extra Count of bytes left free after the content
+ * @param len Output: length of the content
+ * @return The buffer or NULL on error
+ */
+static char *read_whole_file(const char *name, size_t extra, size_t *len);
+
+/**
+ * @brief Learns a classifier from a learning file.
+ *
+ * The examples are parsed with a model having only the description of the
+ * problem, then given to the library by columns.
+ *
+ * @param descr The description of the problem
+ * @param len Length of descr (LEAF can be appended after it)
+ * @param learning Name of the learning file
+ * @param num_handle How to handle numeric attributes
+ * @param missing_handle How to handle missing attributes
+ * @return The model or NULL on error
+ */
+static struct id3_model *learn(char *descr, size_t len, const char *learning,
+		int num_handle, int missing_handle);
+
+/**
+ * @brief Returns the index of a class.
+ *
+ * @param model The model
+ * @param name Name of the class (can be NULL)
+ * @return Index of the class or -1 if not found
+ */
+static int class_index(const struct id3_model *model, const char *name);
+
+/**
+ * @brief Classifies the examples of a testing file.
+ *
+ * @param model The model
+ * @param testing Name of the testing file
+ * @param out Name of the output file
+ * @return 0 on success, -1 on error
+ */
+static int classify(const struct id3_model *model, const char *testing,
+		const char *out);
+
+int main(int argc, char **argv)
+{
+	struct id3_model *model;
+	int num_handle, missing_handle;
+	size_t len;
+	char *buf;
+	FILE *f;
+
+	if (argc != 8) {
+		fprintf(stderr, "Usage: %s div|full|loc maj|prb ATTRIBUTES "
+				"LEARNING TESTING MODEL OUT\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	if (strcmp(argv[1], "div") == 0)
+		num_handle = ID3_NUM_DIV;
+	else if (strcmp(argv[1], "full") == 0)
+		num_handle = ID3_NUM_FULL;
+	else
+		num_handle = ID3_NUM_LOCAL;
+	if (strcmp(argv[2], "maj") == 0)
+		missing_handle = ID3_MISS_MAJ;
+	else
+		missing_handle = ID3_MISS_PRB;
+
+	buf = read_whole_file(argv[3], strlen(LEAF), &len);
+	if (buf == NULL)
+		return EXIT_FAILURE;
+	model = learn(buf, len, argv[4], num_handle, missing_handle);
+	free(buf);
+	if (model == NULL)
+		return EXIT_FAILURE;
+
+	f = fopen(argv[6], "w");
+	if (f == NULL)
+		goto fail;
+	id3_model_write(model, f);
+	fclose(f);
+	id3_model_free(model);
+
+	buf = read_whole_file(argv[6], 0, &len);
+	if (buf == NULL)
+		return EXIT_FAILURE;
+	model = id3_model_load(buf, len);
+	free(buf);
+	if (model == NULL)
+		return EXIT_FAILURE;
+	if (classify(model, argv[5], argv[7]))
+		goto fail;
+	id3_model_free(model);
+	return EXIT_SUCCESS;
+
+fail:
+	id3_model_free(model);
+	return EXIT_FAILURE;
+}
+
+char *read_whole_file(const char *name, size_t extra, size_t *len)
+{
+	char *buf;
+	long size;
+	FILE *f;
+
+	f = fopen(name, "r");
+	if (f == NULL)
+		return NULL;
+	fseek(f, 0, SEEK_END);
+	size = ftell(f);
+	rewind(f);
+	buf = malloc(size + extra + 1);
+	*len = fread(buf, 1, size, f);
+	buf[*len] = '\0';
+	fclose(f);
+	return buf;
+}
+
+struct id3_model *learn(char *descr, size_t len, const char *learning,
+		int num_handle, int missing_handle)
+{
+	struct id3_model *shape, *model;
+	int N, M, i, j, *attr_ids, *classes, **columns;
+	char *line, *copy, *tok, *save;
+	size_t size;
+	FILE *f;
+
+	model = NULL;
+	memcpy(descr + len, LEAF, strlen(LEAF) + 1);
+	shape = id3_model_load(descr, len + strlen(LEAF));
+	if (shape == NULL)
+		return NULL;
+	M = id3_model_attributes(shape);
+
+	f = fopen(learning, "r");
+	if (f == NULL || fscanf(f, "%d ", &N) != 1 || N <= 0)
+		goto noset;
+	attr_ids = calloc(M, sizeof(attr_ids[0]));
+	classes = calloc(N, sizeof(classes[0]));
+	columns = calloc(M, sizeof(columns[0]));
+	for (j = 0; j < M; j++)
+		columns[j] = calloc(N, sizeof(columns[j][0]));
+
+	line = NULL;
+	size = 0;
+	for (i = 0; i < N; i++) {
+		if (getline(&line, &size, f) == -1)
+			goto fail;
+		copy = strdup(line);
+		if (id3_model_parse(shape, line, attr_ids)) {
+			free(copy);
+			goto fail;
+		}
+
+		/* the parser gives 0 for missing values, find them again */
+		tok = strtok_r(copy, " \t\r\n", &save);
+		for (j = 0; j < M; j++) {
+			columns[j][i] = tok[0] == '?' ? ID3_MISSING :
+				attr_ids[j];
+			tok = strtok_r(NULL, " \t\r\n", &save);
+		}
+		classes[i] = class_index(shape, tok);
+		free(copy);
+		if (classes[i] == -1)
+			goto fail;
+	}
+
+	descr[len] = '\0';
+	model = id3_model_learn(descr, len, (const int *const *)columns,
+			classes, N, num_handle, missing_handle);
+
+fail:
+	free(line);
+	for (j = 0; j < M; j++)
+		free(columns[j]);
+	free(columns);
+	free(classes);
+	free(attr_ids);
+noset:
+	if (f)
+		fclose(f);
+	id3_model_free(shape);
+	return model;
+}
+
+int class_index(const struct id3_model *model, const char *name)
+{
+	const char *cls;
+	int k;
+
+	if (name == NULL)
+		return -1;
+	for (k = 0; ; k++) {
+		cls = id3_model_class_name(model, k);
+		if (strcmp(cls, name) == 0)
+			return k;
+		if (strcmp(cls, "unknown") == 0)
+			return -1;
+	}
+}
+
+int classify(const struct id3_model *model, const char *testing,
+		const char *out)
+{
+	int N, i, status, *attr_ids;
+	FILE *in, *f;
+	size_t size;
+	char *line;
+
+	status = -1;
+	in = fopen(testing, "r");
+	if (in == NULL)
+		return -1;
+	attr_ids = calloc(id3_model_attributes(model), sizeof(attr_ids[0]));
+	f = fopen(out, "w");
+	if (f == NULL || fscanf(in, "%d ", &N) != 1)
+		goto fail;
+
+	line = NULL;
+	size = 0;
+	for (i = 0; i < N; i++) {
+		if (getline(&line, &size, in) == -1 ||
+				id3_model_parse(model, line, attr_ids))
+			break;
+		fprintf(f, "%s\n", id3_model_class_name(model,
+				id3_model_classify(model, attr_ids)));
+	}
+	if (i == N)
+		status = 0;
+	free(line);
+
+fail:
+	if (f)
+		fclose(f);
+	fclose(in);
+	free(attr_ids);
+	return status;
+}
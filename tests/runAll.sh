@@ -7,6 +7,36 @@ tests=0
 passed=0
 failed=0
 
+# sends stdin to the server listening on socket $1, prints the answers
+serve_send() {
+    python3 -c '
+import socket, sys
+s = socket.socket(socket.AF_UNIX)
+s.connect(sys.argv[1])
+try:
+    s.sendall(sys.stdin.buffer.read())
+    s.shutdown(socket.SHUT_WR)
+except BrokenPipeError:
+    pass
+while True:
+    b = s.recv(4096)
+    if not b:
+        break
+    sys.stdout.buffer.write(b)
+' $1
+}
+
+# starts the server for model $1 on socket $2, waits until it listens
+# (its messages go to $2.err)
+serve_start() {
+    ./id3 serve $1 $2 2> $2.err &
+    serve_pid=$!
+    for i in $(seq 50); do
+        [ -S $2 ] && break
+        sleep 0.1
+    done
+}
+
 do_tests_learn() {
     tests=$(($tests+1))
     echo -ne "./id3 l atribute.txt invatare.txt out\t\t\t"
@@ -44,6 +74,18 @@ do_tests_learn() {
         failed=$(($failed+1))
     fi
 
+    tests=$(($tests+1))
+    echo -ne "./id3 l -nloc atribute.txt invatare.txt out\t\t"
+    ./id3 l -nloc $1/atribute.txt $1/invatare.txt $1/out
+    diff $1/out $1/out_loc_maj &> /dev/null
+    if [ $? -eq 0 ]; then
+        echo "passed"
+        passed=$(($passed+1))
+    else
+        echo "failed"
+        failed=$(($failed+1))
+    fi
+
     tests=$(($tests+1))
     echo -ne "./id3 l -mmaj atribute.txt invatare.txt out\t\t"
     ./id3 l -mmaj $1/atribute.txt $1/invatare.txt $1/out
@@ -115,6 +157,131 @@ do_tests_learn() {
         echo "failed"
         failed=$(($failed+1))
     fi
+
+    tests=$(($tests+1))
+    echo -ne "./id3 l -d atribute.txt invatare.txt out		"
+    ./id3 l -d $1/atribute.txt $1/invatare.txt $1/out
+    ./id3 g -gscheme $1/out $1/out2
+    diff $1/out2 $1/out_scheme_div_maj &> /dev/null
+    if [ $? -eq 0 ]; then
+        echo "passed"
+        passed=$(($passed+1))
+    else
+        echo "failed"
+        failed=$(($failed+1))
+    fi
+
+    tests=$(($tests+1))
+    echo -ne "./id3 l -ppes atribute.txt invatare.txt out		"
+    ./id3 l -ppes $1/atribute.txt $1/invatare.txt $1/out
+    ./id3 c $1/out $1/test.txt $1/out2
+    diff $1/out2 $1/out_test_div_maj &> /dev/null
+    if [ $? -eq 0 ]; then
+        echo "passed"
+        passed=$(($passed+1))
+    else
+        echo "failed"
+        failed=$(($failed+1))
+    fi
+
+    tests=$(($tests+1))
+    echo -ne "./id3 l -prep -hinvatare.txt atribute.txt invatare.txt out	"
+    ./id3 l -prep -h$1/invatare.txt $1/atribute.txt $1/invatare.txt $1/out
+    ./id3 c $1/out $1/test.txt $1/out2
+    diff $1/out2 $1/out_test_div_maj &> /dev/null
+    if [ $? -eq 0 ]; then
+        echo "passed"
+        passed=$(($passed+1))
+    else
+        echo "failed"
+        failed=$(($failed+1))
+    fi
+
+    tests=$(($tests+1))
+    echo -ne "./id3 forest -t9 -j3 atribute.txt invatare.txt out	"
+    ./id3 forest -t9 -j3 $1/atribute.txt $1/invatare.txt $1/out
+    ./id3 c $1/out $1/test.txt $1/out2
+    ./id3 c -b $1/out $1/test.txt $1/out3
+    diff $1/out2 $1/out3 &> /dev/null
+    if [ $? -eq 0 ]; then
+        echo "passed"
+        passed=$(($passed+1))
+    else
+        echo "failed"
+        failed=$(($failed+1))
+    fi
+
+    tests=$(($tests+1))
+    echo -ne "./id3 cv -k3 -j2 atribute.txt invatare.txt	"
+    ./id3 cv -k3 -j2 $1/atribute.txt $1/invatare.txt > $1/out2 2> /dev/null
+    diff $1/out2 $1/out_cv_div_maj &> /dev/null
+    if [ $? -eq 0 ]; then
+        echo "passed"
+        passed=$(($passed+1))
+    else
+        echo "failed"
+        failed=$(($failed+1))
+    fi
+
+    tests=$(($tests+1))
+    echo -ne "./id3 sweep -j3 -hinvatare.txt atribute.txt invatare.txt sweep	"
+    ./id3 sweep -j3 -h$1/invatare.txt $1/atribute.txt $1/invatare.txt \
+        $1/sweep > $1/out2
+    diff $1/out2 $1/out_sweep &> /dev/null &&
+        diff $1/sweep_full_prb_none $1/out_full_prb &> /dev/null
+    if [ $? -eq 0 ]; then
+        echo "passed"
+        passed=$(($passed+1))
+    else
+        echo "failed"
+        failed=$(($failed+1))
+    fi
+
+    tests=$(($tests+1))
+    echo -ne "./id3 sweep -l0 -l2 -hinvatare.txt atribute.txt invatare.txt\t"
+    ./id3 sweep -nfull -mprb -pnone -l0 -l2 -h$1/invatare.txt \
+        $1/atribute.txt $1/invatare.txt $1/sweep > /dev/null
+    ./id3 l -nfull -mprb -l2 $1/atribute.txt $1/invatare.txt $1/out
+    diff $1/sweep_full_prb_none $1/out_full_prb &> /dev/null &&
+        diff $1/sweep_full_prb_none_2 $1/out &> /dev/null
+    if [ $? -eq 0 ]; then
+        echo "passed"
+        passed=$(($passed+1))
+    else
+        echo "failed"
+        failed=$(($failed+1))
+    fi
+
+    tests=$(($tests+1))
+    echo -ne "./id3 l -o -nfull atribute.txt invatare.txt out	"
+    ./id3 l -o -nfull $1/atribute.txt $1/invatare.txt $1/out
+    ./id3 c $1/out $1/test.txt $1/out2
+    ./id3 c -r$1/profile $1/out $1/test.txt $1/out3
+    diff $1/out2 $1/out3 &> /dev/null
+    if [ $? -eq 0 ]; then
+        echo "passed"
+        passed=$(($passed+1))
+    else
+        echo "failed"
+        failed=$(($failed+1))
+    fi
+
+    tests=$(($tests+1))
+    echo -ne "./id3 l -ndiv/-nfull out #(numeric with one value)\t"
+    printf '2\nC1 C2\n2\nx numeric\ny discret 2 a b\n' > $1/out2
+    printf '4\n5 a C1\n5 b C2\n5 a C1\n5 b C2\n' > $1/out3
+    printf ' y = a\n   ==> C1\n y = b\n   ==> C2\n' > $1/list
+    ./id3 l -ndiv $1/out2 $1/out3 $1/out && ./id3 g $1/out $1/profile &&
+        diff $1/profile $1/list &> /dev/null &&
+        ./id3 l -nfull $1/out2 $1/out3 $1/out &&
+        ./id3 g $1/out $1/profile && diff $1/profile $1/list &> /dev/null
+    if [ $? -eq 0 ]; then
+        echo "passed"
+        passed=$(($passed+1))
+    else
+        echo "failed"
+        failed=$(($failed+1))
+    fi
 }
 
 do_tests_graph(){
@@ -280,7 +447,7 @@ do_tests_graph(){
 
     tests=$(($tests+1))
     echo -ne "./id3 g -gscheme out graph #(div,prb)\t\t\t"
-    ./id3 g -gscheme $1/out_div_prb $1/out_scheme_div_prb
+    ./id3 g -gscheme $1/out_div_prb $1/out
     diff $1/out $1/out_scheme_div_prb &> /dev/null
     if [ $? -eq 0 ]; then
         echo "passed"
@@ -313,6 +480,96 @@ do_tests_graph(){
         echo "failed"
         failed=$(($failed+1))
     fi
+
+    tests=$(($tests+1))
+    echo -ne "./id3 g -gc out graph #(div,maj)\t\t\t\t"
+    ./id3 g -gc $1/out_div_maj $1/out
+    diff $1/out $1/out_c_div_maj &> /dev/null
+    if [ $? -eq 0 ]; then
+        echo "passed"
+        passed=$(($passed+1))
+    else
+        echo "failed"
+        failed=$(($failed+1))
+    fi
+
+    tests=$(($tests+1))
+    echo -ne "./id3 g -gc out graph #(div,prb)\t\t\t\t"
+    ./id3 g -gc $1/out_div_prb $1/out
+    diff $1/out $1/out_c_div_prb &> /dev/null
+    if [ $? -eq 0 ]; then
+        echo "passed"
+        passed=$(($passed+1))
+    else
+        echo "failed"
+        failed=$(($failed+1))
+    fi
+
+    tests=$(($tests+1))
+    echo -ne "./id3 g -gc out graph #(full,maj)\t\t\t\t"
+    ./id3 g -gc $1/out_full_maj $1/out
+    diff $1/out $1/out_c_full_maj &> /dev/null
+    if [ $? -eq 0 ]; then
+        echo "passed"
+        passed=$(($passed+1))
+    else
+        echo "failed"
+        failed=$(($failed+1))
+    fi
+
+    tests=$(($tests+1))
+    echo -ne "./id3 g -gc out graph #(full,prb)\t\t\t\t"
+    ./id3 g -gc $1/out_full_prb $1/out
+    diff $1/out $1/out_c_full_prb &> /dev/null
+    if [ $? -eq 0 ]; then
+        echo "passed"
+        passed=$(($passed+1))
+    else
+        echo "failed"
+        failed=$(($failed+1))
+    fi
+
+    tests=$(($tests+1))
+    echo -ne "./id3 g -gc out graph | cc -c #(full,prb)\t\t"
+    cc -c -Wall -Wextra -Werror -x c $1/out_c_full_prb -o /dev/null \
+        &> /dev/null
+    if [ $? -eq 0 ]; then
+        echo "passed"
+        passed=$(($passed+1))
+    else
+        echo "failed"
+        failed=$(($failed+1))
+    fi
+
+    tests=$(($tests+1))
+    echo -ne "./id3 g -gc out graph | cc -c #(names with */ \" ?)\t"
+    printf '2\nC*/1 C"?\\2\n2\na/*b discret 2 x*/ y"??=\nn*/m numeric\n' \
+        > $1/out2
+    printf '0 0 2 0 1\n1 1 2 5 0\n2 0 0\n3 1 0\n4 1 0\n' >> $1/out2
+    ./id3 g -gc $1/out2 $1/out
+    cc -c -Wall -Wextra -Werror -x c $1/out -o /dev/null &> /dev/null
+    if [ $? -eq 0 ]; then
+        echo "passed"
+        passed=$(($passed+1))
+    else
+        echo "failed"
+        failed=$(($failed+1))
+    fi
+
+    tests=$(($tests+1))
+    echo -ne "./id3 g out graph #(child refers to its parent)\t\t"
+    head -n $((3 + $(sed -n 3p $1/out_full_prb))) $1/out_full_prb > $1/out2
+    printf '0 0 1 0\n0 0 -1\n' >> $1/out2
+    ./id3 g $1/out2 $1/out 2> $1/out3
+    status=$?
+    [ $status -ne 0 ] && [ $status -lt 128 ] && grep -q Error $1/out3
+    if [ $? -eq 0 ]; then
+        echo "passed"
+        passed=$(($passed+1))
+    else
+        echo "failed"
+        failed=$(($failed+1))
+    fi
 }
 
 do_tests_classify(){
@@ -364,17 +621,343 @@ do_tests_classify(){
         failed=$(($failed+1))
     fi
 
+    tests=$(($tests+1))
+    echo -ne "./id3 c -s out - < test.txt #(div,maj)\t\t\t"
+    ./id3 c -s $1/out_div_maj - < $1/test.txt > $1/out
+    diff $1/out $1/out_test_div_maj &> /dev/null
+    if [ $? -eq 0 ]; then
+        echo "passed"
+        passed=$(($passed+1))
+    else
+        echo "failed"
+        failed=$(($failed+1))
+    fi
+
+    tests=$(($tests+1))
+    echo -ne "./id3 c -s -j2 out test.txt result #(full,prb)\t\t"
+    ./id3 c -s -j2 $1/out_full_prb $1/test.txt $1/out
+    diff $1/out $1/out_test_full_prb &> /dev/null
+    if [ $? -eq 0 ]; then
+        echo "passed"
+        passed=$(($passed+1))
+    else
+        echo "failed"
+        failed=$(($failed+1))
+    fi
+
+    tests=$(($tests+1))
+    echo -ne "./id3 c -b out test.txt result #(full,maj)\t\t"
+    ./id3 c -b $1/out_full_maj $1/test.txt $1/out
+    diff $1/out $1/out_test_full_maj &> /dev/null
+    if [ $? -eq 0 ]; then
+        echo "passed"
+        passed=$(($passed+1))
+    else
+        echo "failed"
+        failed=$(($failed+1))
+    fi
+
+    tests=$(($tests+1))
+    echo -ne "./id3 c -b out test_batch.txt result #(full,prb)\t"
+    ./id3 c $1/out_full_prb $1/test_batch.txt $1/out2
+    ./id3 c -b $1/out_full_prb $1/test_batch.txt $1/out
+    diff $1/out $1/out2 &> /dev/null
+    if [ $? -eq 0 ]; then
+        echo "passed"
+        passed=$(($passed+1))
+    else
+        echo "failed"
+        failed=$(($failed+1))
+    fi
+
+    tests=$(($tests+1))
+    echo -ne "./id3 c -c4 out test_cache.txt result #(div,prb)\t"
+    ./id3 c -c4 $1/out_div_prb $1/test_cache.txt $1/out 2> $1/out3
+    diff $1/out $1/out_test_cache_div_prb &> /dev/null &&
+        diff $1/out3 $1/out_cache_div_prb &> /dev/null
+    if [ $? -eq 0 ]; then
+        echo "passed"
+        passed=$(($passed+1))
+    else
+        echo "failed"
+        failed=$(($failed+1))
+    fi
+
+    tests=$(($tests+1))
+    echo -ne "./id3 c -b -c4 out test_cache.txt result #(div,prb)\t"
+    ./id3 c -b -c4 $1/out_div_prb $1/test_cache.txt $1/out 2> $1/out3
+    diff $1/out $1/out_test_cache_div_prb &> /dev/null &&
+        diff $1/out3 $1/out_cache_div_prb &> /dev/null
+    if [ $? -eq 0 ]; then
+        echo "passed"
+        passed=$(($passed+1))
+    else
+        echo "failed"
+        failed=$(($failed+1))
+    fi
+
+    tests=$(($tests+1))
+    echo -ne "./id3 c -b -c4 out test.txt result #(div,prb)\t\t"
+    ./id3 c -b -c4 $1/out_div_prb $1/test.txt $1/out 2> /dev/null
+    diff $1/out $1/out_test_div_prb &> /dev/null
+    if [ $? -eq 0 ]; then
+        echo "passed"
+        passed=$(($passed+1))
+    else
+        echo "failed"
+        failed=$(($failed+1))
+    fi
+
+    tests=$(($tests+1))
+    echo -ne "./id3 c -pprofile out test.txt result #(full,prb)\t"
+    ./id3 c -r$1/profile $1/out_full_prb $1/test.txt > /dev/null
+    ./id3 c -p$1/profile $1/out_full_prb $1/test.txt $1/out
+    diff $1/out $1/out_test_full_prb &> /dev/null
+    if [ $? -eq 0 ]; then
+        echo "passed"
+        passed=$(($passed+1))
+    else
+        echo "failed"
+        failed=$(($failed+1))
+    fi
+
+    tests=$(($tests+1))
+    echo -ne "./id3 c -s -j3 -b out test_batch.txt result #(full,prb)\t"
+    ./id3 c $1/out_full_prb $1/test_batch.txt $1/out2
+    ./id3 c -s -j3 -b $1/out_full_prb $1/test_batch.txt $1/out
+    diff $1/out $1/out2 &> /dev/null
+    if [ $? -eq 0 ]; then
+        echo "passed"
+        passed=$(($passed+1))
+    else
+        echo "failed"
+        failed=$(($failed+1))
+    fi
+
+    tests=$(($tests+1))
+    echo -ne "./id3 c -s -j3 out test_miss.txt result #(full,prb)\t"
+    awk 'NR > 1 && NR < 5 { $(NR - 1) = "?" } { print }' \
+        $1/test_batch.txt > $1/test_miss.txt
+    ./id3 c $1/out_full_prb $1/test_miss.txt $1/out3 2> /dev/null
+    r1=$?
+    ./id3 c -s $1/out_full_prb - < $1/test_miss.txt > $1/out2 2> /dev/null
+    r2=$?
+    ./id3 c -s -j3 $1/out_full_prb $1/test_miss.txt $1/out 2> /dev/null
+    r3=$?
+    rm -f $1/test_miss.txt
+    [ $r1 -eq $r2 ] && [ $r2 -eq $r3 ] && diff $1/out $1/out2 &> /dev/null
+    if [ $? -eq 0 ]; then
+        echo "passed"
+        passed=$(($passed+1))
+    else
+        echo "failed"
+        failed=$(($failed+1))
+    fi
+
+    tests=$(($tests+1))
+    echo -ne "./id3 c -j2 out -flist #(div,prb)\t\t\t"
+    echo "$1/test.txt $1/out" > $1/list
+    echo "$1/test.txt $1/out2" >> $1/list
+    ./id3 c -j2 $1/out_div_prb -f$1/list
+    diff $1/out $1/out_test_div_prb &> /dev/null &&
+        diff $1/out2 $1/out_test_div_prb &> /dev/null
+    if [ $? -eq 0 ]; then
+        echo "passed"
+        passed=$(($passed+1))
+    else
+        echo "failed"
+        failed=$(($failed+1))
+    fi
+
 }
 
-for d in tests/*; do
+do_tests_lib(){
+    tests=$(($tests+1))
+    echo -ne "libtest full prb (through libid3)\t\t\t"
+    tests/libtest full prb $1/atribute.txt $1/invatare.txt $1/test.txt \
+        $1/out2 $1/out
+    diff $1/out2 $1/out_full_prb &> /dev/null &&
+        diff $1/out $1/out_test_full_prb &> /dev/null
+    if [ $? -eq 0 ]; then
+        echo "passed"
+        passed=$(($passed+1))
+    else
+        echo "failed"
+        failed=$(($failed+1))
+    fi
+
+    tests=$(($tests+1))
+    echo -ne "libtest div maj (through libid3)\t\t\t"
+    tests/libtest div maj $1/atribute.txt $1/invatare.txt $1/test.txt \
+        $1/out2 $1/out
+    diff $1/out2 $1/out_div_maj &> /dev/null &&
+        diff $1/out $1/out_test_div_maj &> /dev/null
+    if [ $? -eq 0 ]; then
+        echo "passed"
+        passed=$(($passed+1))
+    else
+        echo "failed"
+        failed=$(($failed+1))
+    fi
+}
+
+do_tests_serve(){
+    cp $1/out_full_prb $1/model
+    serve_start $1/model $1/sock
+
+    tests=$(($tests+1))
+    echo -ne "./id3 serve out sock < test.txt #(full,prb)		"
+    tail -n +2 $1/test.txt | serve_send $1/sock > $1/out
+    diff $1/out $1/out_test_full_prb &> /dev/null
+    if [ $? -eq 0 ]; then
+        echo "passed"
+        passed=$(($passed+1))
+    else
+        echo "failed"
+        failed=$(($failed+1))
+    fi
+
+    tests=$(($tests+1))
+    echo -ne "./id3 serve out sock < long line #(full,prb)		"
+    (head -c 70000 /dev/zero | tr '\0' 'x'; echo; tail -n +2 $1/test.txt) |
+        serve_send $1/sock > $1/out
+    tail -n +2 $1/test.txt | serve_send $1/sock > $1/out2
+    echo "error" | diff $1/out - &> /dev/null &&
+        diff $1/out2 $1/out_test_full_prb &> /dev/null
+    if [ $? -eq 0 ]; then
+        echo "passed"
+        passed=$(($passed+1))
+    else
+        echo "failed"
+        failed=$(($failed+1))
+    fi
+
+    tests=$(($tests+1))
+    echo -ne "kill -HUP serve, new model #(leaf)\t\t\t"
+    # a tree with a single leaf giving the first class
+    head -n $((3 + $(sed -n 3p $1/out_full_prb))) $1/out_full_prb > $1/model
+    echo "0 0 0" >> $1/model
+    cls=$(sed -n 2p $1/model | cut -d' ' -f1)
+    tail -n +2 $1/test.txt | sed "s/.*/$cls/" > $1/out3
+    kill -HUP $serve_pid
+    for i in $(seq 50); do
+        tail -n +2 $1/test.txt | serve_send $1/sock > $1/out
+        diff $1/out $1/out3 &> /dev/null && break
+        sleep 0.1
+    done
+    diff $1/out $1/out3 &> /dev/null
+    if [ $? -eq 0 ]; then
+        echo "passed"
+        passed=$(($passed+1))
+    else
+        echo "failed"
+        failed=$(($failed+1))
+    fi
+
+    tests=$(($tests+1))
+    echo -ne "kill -HUP serve, broken model #(leaf)\t\t\t"
+    echo "broken" > $1/model
+    kill -HUP $serve_pid
+    for i in $(seq 50); do
+        grep -q "Cannot reload" $1/sock.err && break
+        sleep 0.1
+    done
+    tail -n +2 $1/test.txt | serve_send $1/sock > $1/out
+    grep -q "Cannot reload" $1/sock.err &&
+        diff $1/out $1/out3 &> /dev/null
+    if [ $? -eq 0 ]; then
+        echo "passed"
+        passed=$(($passed+1))
+    else
+        echo "failed"
+        failed=$(($failed+1))
+    fi
+
+    kill $serve_pid
+    wait $serve_pid
+}
+
+# noisy examples: each pruning method removes some nodes of the tree
+do_tests_prune(){
+    tests=$(($tests+1))
+    echo -ne "./id3 l atribute.txt invatare.txt out | id3 g\t\t"
+    ./id3 l $1/atribute.txt $1/invatare.txt $1/out
+    ./id3 g $1/out $1/out2
+    diff $1/out2 $1/out_ascii_none &> /dev/null
+    if [ $? -eq 0 ]; then
+        echo "passed"
+        passed=$(($passed+1))
+    else
+        echo "failed"
+        failed=$(($failed+1))
+    fi
+
+    tests=$(($tests+1))
+    echo -ne "./id3 l -pcol atribute.txt invatare.txt out | id3 g\t"
+    ./id3 l -pcol $1/atribute.txt $1/invatare.txt $1/out
+    ./id3 g $1/out $1/out2
+    diff $1/out2 $1/out_ascii_col &> /dev/null
+    if [ $? -eq 0 ]; then
+        echo "passed"
+        passed=$(($passed+1))
+    else
+        echo "failed"
+        failed=$(($failed+1))
+    fi
+
+    tests=$(($tests+1))
+    echo -ne "./id3 l -ppes atribute.txt invatare.txt out | id3 g\t"
+    ./id3 l -ppes $1/atribute.txt $1/invatare.txt $1/out
+    ./id3 g $1/out $1/out2
+    diff $1/out2 $1/out_ascii_pes &> /dev/null
+    if [ $? -eq 0 ]; then
+        echo "passed"
+        passed=$(($passed+1))
+    else
+        echo "failed"
+        failed=$(($failed+1))
+    fi
+
+    tests=$(($tests+1))
+    echo -ne "./id3 l -prep -hholdout.txt ... out | id3 g\t\t"
+    ./id3 l -prep -h$1/holdout.txt $1/atribute.txt $1/invatare.txt $1/out
+    ./id3 g $1/out $1/out2
+    diff $1/out2 $1/out_ascii_rep &> /dev/null
+    if [ $? -eq 0 ]; then
+        echo "passed"
+        passed=$(($passed+1))
+    else
+        echo "failed"
+        failed=$(($failed+1))
+    fi
+}
+
+for d in tests/[0-9]*; do
     if [ -d $d ]; then
         do_tests_learn $d
         do_tests_graph $d
         do_tests_classify $d
-        rm -f $d/out
+        do_tests_lib $d
+        do_tests_serve $d
+        rm -f $d/out $d/out2 $d/out3 $d/sweep_* $d/list $d/profile $d/sock \
+            $d/sock.err $d/model
     fi
 done
 
+do_tests_prune tests/prune
+rm -f tests/prune/out tests/prune/out2
+
+tests=$(($tests+1))
+echo -ne "nm -D libid3.so #(only id3_model_* exported)\t\t"
+[ -z "$(nm -D --defined-only libid3.so | grep -v ' id3_model_')" ]
+if [ $? -eq 0 ]; then
+    echo "passed"
+    passed=$(($passed+1))
+else
+    echo "failed"
+    failed=$(($failed+1))
+fi
+
 echo -ne "============ SUMMARY =============\n"
 echo -ne "TESTS:\t\t\t$tests\n"
 echo -ne "FAILED:\t\t\t$failed\n"